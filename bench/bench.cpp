@@ -0,0 +1,434 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+#include "forcekernel.hpp"
+#include "geometry.hpp"
+#include "gravity.hpp"
+#include "planet.hpp"
+#include "morton.hpp"
+#include "scene.hpp"
+#include "spatialhash.hpp"
+#include "utils.hpp"
+#include "vector2d.hpp"
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/*
+ * Microbenchmarks for the physics and geometry hot paths. Every case runs once as warmup, then
+ * --repeat timed runs, each long enough to take --min-time seconds. The fastest and the median
+ * run are reported per item (interaction, vertex, call) so numbers compare across sizes, and the
+ * whole table can be written as JSON to diff between commits.
+ *
+ * Pair counts are unique pairs: the direct sum kernels apply each pair to both bodies, so one
+ * interaction is one pair evaluated and written twice.
+ */
+
+#define BENCH_MAX_PAIRS (1 << 22) //Pairs per iteration, large N only runs the first rows
+
+typedef struct {
+    std::string name;
+    size_t n; //Problem size, bodies or segments
+    double items; //Interactions or calls per iteration
+    double bytes; //Bytes read and written per iteration
+    double bestSeconds; //Per iteration
+    double medianSeconds;
+    unsigned long iterations; //Per timed run
+    double missesPerItem; //Last level cache read misses over all timed runs, negative when not counted
+}BenchResult;
+
+typedef struct {
+    unsigned int repeat;
+    double minTime;
+    size_t maxBodies;
+    std::string filter;
+}BenchOptions;
+
+//Results go through here so the compiler cannot drop the work
+static volatile float sink;
+
+/*
+ * Last level cache read misses of the calling thread, user space only. Needs a kernel that allows
+ * perf_event_open (perf_event_paranoid <= 2, and not blocked by a container or VM); when it is not
+ * allowed the counter is unavailable and the bench reports n/a instead of a number.
+ */
+class MissCounter {
+    public:
+        MissCounter(){
+            this->fd = -1;
+#ifdef __linux__
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            this->fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+        }
+        ~MissCounter(){
+#ifdef __linux__
+            if(this->fd >= 0){
+                close(this->fd);
+            }
+#endif
+        }
+        MissCounter(const MissCounter&) = delete;
+        MissCounter& operator=(const MissCounter&) = delete;
+        bool available() const{
+            return this->fd >= 0;
+        }
+        void start(){
+#ifdef __linux__
+            if(this->fd >= 0){
+                ioctl(this->fd, PERF_EVENT_IOC_RESET, 0);
+                ioctl(this->fd, PERF_EVENT_IOC_ENABLE, 0);
+            }
+#endif
+        }
+        //Misses since start, negative when unavailable
+        double stop(){
+#ifdef __linux__
+            unsigned long long count;
+            if(this->fd >= 0){
+                ioctl(this->fd, PERF_EVENT_IOC_DISABLE, 0);
+                if(read(this->fd, &count, sizeof(count)) == sizeof(count)){
+                    return count;
+                }
+            }
+#endif
+            return -1.0;
+        }
+    private:
+        int fd;
+};
+
+static double now(){
+    return std::chrono::duration<double>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static bool selected(const BenchOptions& options, const std::string& name){
+    return options.filter.empty() || name.find(options.filter) != std::string::npos;
+}
+
+//With misses, the timed runs also count last level cache misses on this thread and report them per item
+static void runBenchmark(const BenchOptions& options, std::vector<BenchResult>& results, const std::string& name, size_t n, double items, double bytes, const std::function<void()>& iteration,
+                         MissCounter* misses = nullptr){
+    if(!selected(options, name)){
+        return;
+    }
+
+    //Warmup, also sizes the timed runs
+    double start = now();
+    iteration();
+    double single = std::max(now() - start, 1e-9);
+    unsigned long iterations = std::max(1.0, options.minTime / single);
+
+    std::vector<double> runs;
+    double missCount = 0.0;
+    for(unsigned int run = 0; run < options.repeat; run++){
+        if(misses != nullptr){
+            misses->start();
+        }
+        start = now();
+        for(unsigned long i = 0; i < iterations; i++){
+            iteration();
+        }
+        runs.push_back((now() - start) / iterations);
+        if(misses != nullptr){
+            missCount += misses->stop();
+        }
+    }
+    std::sort(runs.begin(), runs.end());
+
+    double missesPerItem = -1.0;
+    if(misses != nullptr && misses->available()){
+        missesPerItem = missCount / ((double)options.repeat * iterations * items);
+    }
+    BenchResult result = {name, n, items, bytes, runs.front(), runs[runs.size() / 2], iterations, missesPerItem};
+    results.push_back(result);
+    std::cout.setf(std::ios::fixed);
+    std::cout.precision(2);
+    std::cout << name << " n=" << n << ": " << result.bestSeconds * 1e9 / items << " ns/item (median "
+              << result.medianSeconds * 1e9 / items << "), " << items / result.bestSeconds / 1e6 << " M items/s, "
+              << bytes / result.bestSeconds / 1e9 << " GB/s";
+    if(misses != nullptr){
+        if(missesPerItem >= 0.0){
+            std::cout << ", " << std::setprecision(4) << missesPerItem << " LLC misses/item";
+        }else{
+            std::cout << ", LLC misses n/a";
+        }
+    }
+    std::cout << std::endl;
+}
+
+static void writeJson(const std::vector<BenchResult>& results, std::ofstream& out){
+    out.precision(6);
+    out << "{\"benchmarks\":[";
+    for(size_t i = 0; i < results.size(); i++){
+        const BenchResult& result = results[i];
+        out << (i == 0 ? "\n" : ",\n")
+            << "{\"name\":\"" << result.name << "\",\"n\":" << result.n
+            << ",\"items\":" << result.items << ",\"iterations\":" << result.iterations
+            << ",\"best_ns_per_item\":" << result.bestSeconds * 1e9 / result.items
+            << ",\"median_ns_per_item\":" << result.medianSeconds * 1e9 / result.items
+            << ",\"items_per_second\":" << result.items / result.bestSeconds
+            << ",\"bytes_per_second\":" << result.bytes / result.bestSeconds;
+        if(result.missesPerItem >= 0.0){
+            out << ",\"llc_misses_per_item\":" << result.missesPerItem;
+        }
+        out << "}";
+    }
+    out << "\n]}\n";
+}
+
+//Number of pairs (i, j > i) in the first rows rows of count bodies
+static double pairsInRows(size_t rows, size_t count){
+    return (double)rows * (count - 1) - (double)rows * (rows - 1) / 2;
+}
+
+/* Physics */
+
+static void benchPair(const BenchOptions& options, std::vector<BenchResult>& results){
+    //The scalar kernel's per pair path, one body against a block of sources kept in cache
+    const size_t partners = 4096;
+    ParticleSystem particles;
+    loadDisk(particles, partners, 1);
+    ForceParams params = {(float)G_CONST, MIN_DISTANCE_THRESHOLD, PLUMMER_SOFTENING * PLUMMER_SOFTENING};
+    ForceKernel kernel;
+    getForceKernel(KernelIsa::Scalar, kernel);
+    float ax = 0.0f, ay = 0.0f;
+    runBenchmark(options, results, "sourceSum/scalar", partners, partners, partners * 3 * sizeof(float), [&]{
+        ax = ay = 0.0f;
+        kernel.sourceSum(params, particles.x.data(), particles.y.data(), particles.mass.data(), &ax, &ay, 0, 1, 0, partners);
+        sink = ax + ay;
+    });
+}
+
+static void benchKernels(const BenchOptions& options, std::vector<BenchResult>& results){
+    ForceParams params = {(float)G_CONST, MIN_DISTANCE_THRESHOLD, PLUMMER_SOFTENING * PLUMMER_SOFTENING};
+    KernelIsa isas[] = {KernelIsa::Scalar, KernelIsa::SSE2, KernelIsa::AVX2, KernelIsa::AVX512};
+    for(size_t n = 10; n <= options.maxBodies; n *= 10){
+        ParticleSystem particles;
+        loadDisk(particles, n - 1, 1); //Plus the sun
+        std::vector<float> ax(n), ay(n);
+
+        //Rows from the start are the longest, so few rows still stream the whole arrays
+        size_t rows = n;
+        while(rows > 1 && pairsInRows(rows, n) > BENCH_MAX_PAIRS){
+            rows /= 2;
+        }
+        double pairs = pairsInRows(rows, n);
+        //Each pair streams x, y and mass of j and updates ax, ay of j
+        double bytes = pairs * (3 * sizeof(float) + 4 * sizeof(float));
+
+        for(ForceLaw law: {ForceLaw::NewtonCutoff, ForceLaw::Plummer}){
+            for(KernelIsa isa: isas){
+                ForceKernel kernel;
+                if(!getForceKernel(isa, kernel, law)){
+                    continue;
+                }
+                std::string name = std::string("directSum/") + kernel.name + (law == ForceLaw::Plummer ? "/plummer" : "");
+                runBenchmark(options, results, name, n, pairs, bytes, [&]{
+                    std::fill(ax.begin(), ax.end(), 0.0f);
+                    std::fill(ay.begin(), ay.end(), 0.0f);
+                    kernel.directSum(params, particles.x.data(), particles.y.data(), particles.mass.data(), ax.data(), ay.data(), 0, rows, n);
+                    sink = ax[0];
+                });
+            }
+        }
+    }
+}
+
+static void benchSolver(const BenchOptions& options, std::vector<BenchResult>& results){
+    //Whole force pass through the solver on every thread, pairs for direct sum and bodies for the others
+    ThreadPool pool;
+    for(size_t n = 1000; n <= std::min(options.maxBodies, (size_t)100000); n *= 10){
+        ParticleSystem particles;
+        loadDisk(particles, n - 1, 1);
+        double bytes = n * 5 * sizeof(float);
+        if(n <= 10000){
+            GravitySolver direct = GravitySolver(ForceSolver::DirectSum, BARNES_HUT_THETA, &pool);
+            runBenchmark(options, results, "GravitySolver/direct", n, pairsInRows(n, n), bytes, [&]{
+                direct.calculateAccelerations(particles);
+                sink = particles.ax[0];
+            });
+        }
+        GravitySolver barnesHut = GravitySolver(ForceSolver::BarnesHut, BARNES_HUT_THETA, &pool);
+        runBenchmark(options, results, "GravitySolver/barnes-hut", n, n, bytes, [&]{
+            barnesHut.calculateAccelerations(particles);
+            sink = particles.ax[0];
+        });
+        GravitySolver mesh = GravitySolver(ForceSolver::ParticleMesh, BARNES_HUT_THETA, &pool);
+        runBenchmark(options, results, "GravitySolver/particle-mesh", n, n, bytes, [&]{
+            mesh.calculateAccelerations(particles);
+            sink = particles.ax[0];
+        });
+        GravitySolver multipole = GravitySolver(ForceSolver::FastMultipole, BARNES_HUT_THETA, &pool);
+        runBenchmark(options, results, "GravitySolver/fast-multipole", n, n, bytes, [&]{
+            multipole.calculateAccelerations(particles);
+            sink = particles.ax[0];
+        });
+    }
+}
+
+static void benchLocality(const BenchOptions& options, std::vector<BenchResult>& results){
+    //The disk comes out of loadDisk in random order; the same force pass before and after a Morton
+    //sort, on one thread so only the memory access pattern differs. Both passes count their last
+    //level cache misses, the n/a they print where perf events are not allowed leaves that to perf stat
+    MissCounter misses;
+    if(!misses.available() && (selected(options, "BarnesHut/unsorted") || selected(options, "BarnesHut/morton"))){
+        std::cout << "LLC miss counter unavailable (perf_event_open not permitted), run under perf stat -e LLC-load-misses for miss counts" << std::endl;
+    }
+    for(size_t n = 100000; n <= std::min(options.maxBodies, (size_t)1000000); n *= 10){
+        ParticleSystem particles;
+        loadDisk(particles, n - 1, 1);
+        double bytes = n * 5 * sizeof(float);
+        GravitySolver solver = GravitySolver(ForceSolver::BarnesHut, BARNES_HUT_THETA);
+        runBenchmark(options, results, "BarnesHut/unsorted", n, n, bytes, [&]{
+            solver.calculateAccelerations(particles);
+            sink = particles.ax[0];
+        }, &misses);
+
+        //Sorted outside the timed cases so filtering them out does not change what the next one sees
+        MortonSorter sorter;
+        sorter.sort(particles);
+        runBenchmark(options, results, "MortonSorter/sort", n, n, n * 11 * sizeof(float) * 2, [&]{
+            sorter.sort(particles);
+            sink = particles.x[0];
+        });
+        runBenchmark(options, results, "BarnesHut/morton", n, n, bytes, [&]{
+            solver.calculateAccelerations(particles);
+            sink = particles.ax[0];
+        }, &misses);
+    }
+}
+
+static void benchCollisions(const BenchOptions& options, std::vector<BenchResult>& results){
+    //Broadphase over a disk, the sun is the one large body
+    for(size_t n = 1000; n <= std::min(options.maxBodies, (size_t)1000000); n *= 10){
+        ParticleSystem particles;
+        loadDisk(particles, n - 1, 1);
+        std::vector<float> radius(n);
+        for(size_t i = 0; i < n; i++){
+            radius[i] = bodyRadius(particles.mass[i]);
+        }
+        SpatialHash grid;
+        std::vector<std::pair<int, int>> pairs;
+        runBenchmark(options, results, "SpatialHash/findOverlaps", n, n, n * 3 * sizeof(float), [&]{
+            grid.findOverlaps(particles, radius, pairs);
+            sink = pairs.size();
+        });
+    }
+}
+
+/* Geometry and utilities */
+
+static void benchGeometry(const BenchOptions& options, std::vector<BenchResult>& results){
+    for(unsigned int segments: {16u, 64u, 256u}){
+        double bytes = (segments + 1) * 3 * sizeof(float);
+        runBenchmark(options, results, "circleVertices", segments, segments + 1, bytes, [&]{
+            std::vector<float> vertices = circleVertices({0.0f, 0.0f}, 1.0f, segments);
+            sink = vertices.back();
+        });
+        bytes = segments * 3 * sizeof(unsigned int);
+        runBenchmark(options, results, "circleIndices", segments, segments * 3, bytes, [&]{
+            std::vector<unsigned int> indices = circleIndices(segments);
+            sink = indices.back();
+        });
+    }
+}
+
+static void benchUtils(const BenchOptions& options, std::vector<BenchResult>& results){
+    const size_t count = 4096;
+    std::vector<int> colors(count);
+    std::vector<Vector2D> vectors(count);
+    std::mt19937 random(1);
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    for(size_t i = 0; i < count; i++){
+        colors[i] = random() & 0xFFFFFF;
+        vectors[i] = {distribution(random), distribution(random)};
+    }
+
+    runBenchmark(options, results, "hex2rgb", count, count, count * (sizeof(int) + sizeof(RGB)), [&]{
+        float sum = 0.0f;
+        for(size_t i = 0; i < count; i++){
+            RGB color = hex2rgb(colors[i]);
+            sum += color.r + color.g + color.b;
+        }
+        sink = sum;
+    });
+    runBenchmark(options, results, "Vector2D", count, count, count * sizeof(Vector2D), [&]{
+        //One add, subtract, scale, dot and normalize per element
+        Vector2D sum = {0.0f, 0.0f};
+        for(size_t i = 0; i + 1 < count; i++){
+            Vector2D difference = vectors[i + 1] - vectors[i];
+            sum = sum + difference.normalize() * vectors[i].dot(difference);
+        }
+        sink = sum.x + sum.y;
+    });
+}
+
+static void printUsage(){
+    std::cout << "Usage: bench [options]\n"
+              << "  --filter TEXT    only run benchmarks whose name contains TEXT\n"
+              << "  --repeat N       timed runs per benchmark (default 5)\n"
+              << "  --min-time X     seconds per timed run (default 0.1)\n"
+              << "  --max-bodies N   largest direct sum size (default 1000000)\n"
+              << "  --json FILE      also write the results as JSON\n";
+}
+
+int main(int argc, char** argv){
+    BenchOptions options = {5, 0.1, 1000000, ""};
+    const char* json = nullptr;
+    for(int i = 1; i < argc; i++){
+        bool hasValue = i + 1 < argc;
+        if(std::strcmp(argv[i], "--filter") == 0 && hasValue){
+            options.filter = argv[++i];
+        }else if(std::strcmp(argv[i], "--repeat") == 0 && hasValue){
+            options.repeat = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        }else if(std::strcmp(argv[i], "--min-time") == 0 && hasValue){
+            options.minTime = std::atof(argv[++i]);
+        }else if(std::strcmp(argv[i], "--max-bodies") == 0 && hasValue){
+            options.maxBodies = std::strtoul(argv[++i], nullptr, 10);
+        }else if(std::strcmp(argv[i], "--json") == 0 && hasValue){
+            json = argv[++i];
+        }else{
+            printUsage();
+            return std::strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    std::vector<BenchResult> results;
+    benchPair(options, results);
+    benchKernels(options, results);
+    benchSolver(options, results);
+    benchLocality(options, results);
+    benchCollisions(options, results);
+    benchGeometry(options, results);
+    benchUtils(options, results);
+
+    if(json != nullptr){
+        std::ofstream file(json);
+        writeJson(results, file);
+        if(!file.good()){
+            std::cerr << "Error: Unable to write " << json << std::endl;
+            return 1;
+        }
+        std::cout << "Wrote " << json << std::endl;
+    }
+    return 0;
+}
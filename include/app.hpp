@@ -9,6 +9,11 @@
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <string>
+#include "geometry.hpp"
+#include "glstate.hpp"
+#include "meshcache.hpp"
+#include "shader.hpp"
 
 const unsigned int SCR_WIDTH = 1920;
 const unsigned int SCR_HEIGHT = 1080;
@@ -29,18 +34,33 @@ class OpenGLApp{
         float zoomLevel;
         OrthoMatrix orthoInfo;
         GLFWwindow* window;
-        unsigned int shaderProgram;
+        ShaderProgram shaderProgram;
+        ShaderProgram instancedShaderProgram;
+        ShaderProgram sdfShaderProgram;
+        GLStateCache glState;
+        MeshCache meshCache; //After glState, which it binds through
+        const Mesh* circleLodMeshes[CIRCLE_LOD_COUNT]; //Never released, so every level stays built while the app lives
         float scaleFactor;
     public:
         OpenGLApp(GLFWwindow* window);
+        //Also builds the unit circle of every level of detail for the shape shader
         bool parseShaders();
+        unsigned int loadShaderProgram(const std::string& vertexFile, const std::string& fragmentFile);
         void moveCamera(float x, float y);
         void zoomCamera(float zoom);
         void updateCamera();
         bool cameraUpdated();
         glm::mat4 getCamera();
         bool cameraUpdate;
-        unsigned int getShaderProgram();
+        const ShaderProgram& getShaderProgram();
+        const ShaderProgram& getInstancedShaderProgram();
+        const ShaderProgram& getSdfShaderProgram();
+        //World units (after the scale factor) covered by one framebuffer pixel along x and y
+        glm::vec2 getPixelSize();
+        //Visible area in world units (after the scale factor): left, bottom, right, top
+        glm::vec4 getViewRect();
+        GLStateCache& getGLState();
+        MeshCache& getMeshCache();
         float getScaleFactor();
         void setScaleFactor(float scaleFactor);
 };
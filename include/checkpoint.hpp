@@ -0,0 +1,34 @@
+#pragma once
+#include <string>
+#include "simulation.hpp"
+
+#define CHECKPOINT_MAGIC "PLNTCKPT"
+#define CHECKPOINT_VERSION 1
+#define CHECKPOINT_HEADER_SIZE 256
+#define CHECKPOINT_ALIGNMENT 64 //Every section starts on a cache line
+
+/*
+ * Binary checkpoint of a Simulation: every body array, the stable ids, names and colors, the
+ * simulation time and step count, the step size, the integrator with its pending accelerations and
+ * the force law, so a run resumes exactly where it stopped.
+ *
+ * Layout, all little endian: a CHECKPOINT_HEADER_SIZE byte header (magic, version, counts, scalars
+ * and the offset of every section) followed by the sections, one array each, in CheckpointSection
+ * order. Readers check the magic and version and refuse a file whose sections do not fit in it.
+ *
+ * Writes go to path + ".tmp", are flushed to disk and renamed over path, so a crash leaves either
+ * the old checkpoint or the new one, never half of one. Reads map the file and copy the sections
+ * straight into the body arrays, nothing is parsed.
+ */
+enum class CheckpointSection {
+    X, Y, VX, VY, AX, AY, Mass, PrevX, PrevY, //float per body
+    Ids, //uint32 per body
+    Colors, //r, g, b floats per body
+    NameOffsets, //uint64 per body plus one, into NameBytes
+    NameBytes,
+    Count
+};
+
+bool saveCheckpoint(const Simulation& simulation, const std::string& path);
+//Replaces the simulation's bodies and state, the solver gets the saved force law
+bool loadCheckpoint(const std::string& path, Simulation& simulation);
@@ -0,0 +1,25 @@
+#pragma once
+#include <utility>
+#include <vector>
+#include "particlesystem.hpp"
+#include "spatialhash.hpp"
+
+/*
+ * Perfectly inelastic collisions: touching bodies (closer than the sum of their bodyRadius) merge
+ * into one at their center of mass with their total mass and momentum. The heavier body survives
+ * and keeps its name and color, the other is removed with swap and pop.
+ *
+ * A body takes part in at most one merge per pass, so a chain of touching bodies collapses over a
+ * few steps rather than in an order dependent way. All scratch space is kept between passes.
+ */
+class Collisions {
+    public:
+        //Returns the number of bodies removed, the integrator must be reset when it is not 0
+        size_t merge(ParticleSystem& particles);
+    private:
+        SpatialHash grid;
+        std::vector<float> radius;
+        std::vector<std::pair<int, int>> pairs;
+        std::vector<char> merged; //Body already took part in a merge this pass
+        std::vector<int> removed;
+};
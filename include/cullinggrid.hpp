@@ -0,0 +1,46 @@
+#pragma once
+#include <vector>
+
+#define CULLING_GRID_BODIES_PER_CELL 8
+#define CULLING_GRID_OUTLIERS 0.001 //Fraction of bodies on each side left out of the grid's extent
+#define CULLING_GRID_SAMPLES 8192 //Bodies sampled to find that extent
+
+typedef struct {
+    float minX;
+    float minY;
+    float maxX;
+    float maxY;
+}CullingRect;
+
+/*
+ * Uniform grid over the bodies' bounding box for view culling. Each body's bounds cover its disc at
+ * the previous and the current step, so anything interpolated between them is found too. Cells
+ * keep the union of their bodies' bounds: cells outside the view are skipped whole, cells inside
+ * it are taken whole, and only the cells on its edge test their bodies one by one.
+ *
+ * Bodies are binned by center with a counting sort, O(N) per build into buffers kept from the
+ * last one. The grid only spans the bulk of the bodies; those outside it (escapers) and those whose
+ * bounds reach further than a cell from their center (the sun, fast movers) are kept in a short
+ * list and tested on their own.
+ */
+class CullingGrid {
+    public:
+        CullingGrid();
+        void build(const std::vector<float>& x, const std::vector<float>& y, const std::vector<float>& prevX,
+                   const std::vector<float>& prevY, const std::vector<float>& mass);
+        //Replaces visible with the index of every body whose bounds touch view
+        void query(const CullingRect& view, std::vector<unsigned int>& visible) const;
+    private:
+        float originX;
+        float originY;
+        float cellSize;
+        int columns;
+        int rows;
+        std::vector<CullingRect> bodyBounds;
+        std::vector<CullingRect> cellBounds;
+        std::vector<unsigned int> cellStart; //Bodies of cell c are order[cellStart[c], cellStart[c + 1])
+        std::vector<unsigned int> order;
+        std::vector<int> cellOf; //Cell of each body, -1 for the large ones
+        std::vector<unsigned int> large; //Outside the grid or larger than a cell
+        std::vector<float> scratch;
+};
@@ -0,0 +1,36 @@
+#pragma once
+#include <complex>
+#include <vector>
+#include "threadpool.hpp"
+
+typedef std::complex<float> Complex;
+
+//Plain product, operator* handles infinite and NaN parts through a __mulsc3 call on every multiply
+inline Complex multiply(Complex a, Complex b){
+    return Complex(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+}
+
+/*
+ * Square 2D complex FFT, radix-2 so size must be a power of two. Data is row major, size * size.
+ * Rows and columns are split into pool blocks; every 1D transform is independent so the result
+ * does not depend on the thread count. Neither direction scales, an inverse after a forward
+ * multiplies by size * size.
+ */
+class FFT2D {
+    public:
+        FFT2D(unsigned int size = 0);
+        unsigned int getSize() const;
+        //Rows from usedRows on must be zero, their row transforms are skipped
+        void forward(std::vector<Complex>& data, unsigned int usedRows, ThreadPool* pool);
+        //Only the first neededRows rows of the result are computed, the rest hold column transforms
+        void inverse(std::vector<Complex>& data, unsigned int neededRows, ThreadPool* pool);
+    private:
+        unsigned int size;
+        unsigned int levels;
+        std::vector<Complex> twiddles; //exp(-2 pi i k / size) for k < size / 2
+        std::vector<unsigned int> bitReverse;
+        std::vector<std::vector<Complex>> columns; //Column block copy per thread
+        void transform(Complex* values, bool inverse) const;
+        void transformRows(std::vector<Complex>& data, unsigned int rows, bool inverse, ThreadPool* pool);
+        void transformColumns(std::vector<Complex>& data, bool inverse, ThreadPool* pool);
+};
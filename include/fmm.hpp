@@ -0,0 +1,60 @@
+#pragma once
+#include <complex>
+#include <vector>
+#include "forcekernel.hpp"
+#include "particlesystem.hpp"
+#include "quadtree.hpp"
+#include "threadpool.hpp"
+
+#define FMM_ORDER 6 //Terms per direction, error falls roughly as theta^FMM_ORDER
+#define FMM_LEAF_SIZE 128 //Bodies per leaf, pairs within neighbouring leaves are summed directly
+
+/*
+ * Fast multipole method for the 1/r^2 law, O(N) for a fixed order and opening angle.
+ *
+ * The potential kernel 1/|z - a| of bodies at complex positions z and a factors into
+ * (z - a)^-1/2 * conj((z - a)^-1/2), and (1 - w)^-1/2 = sum c_k w^k with c_k = binom(2k, k) / 4^k.
+ * Expansions therefore carry P x P complex coefficients in powers of a and conj(a) (multipole,
+ * M_kl = sum m a^k conj(a)^l) or of t and conj(t) (local), and every translation is the product of
+ * two one dimensional complex series. The order P is a template parameter so the coefficient
+ * tables are constexpr and every loop has a constant trip count the compiler can unroll.
+ *
+ * Cells are the nodes of the Barnes-Hut quadtree, expanded about their center of mass. A dual tree
+ * walk pairs cells whose radii sum to less than theta times their distance (and whose closest
+ * bodies are beyond the force law's farField, where it is plain 1/r^2) and sums the remaining
+ * leaf pairs directly with the SIMD source sum kernel on copies of the arrays in tree order, where
+ * every leaf is a contiguous range. The walk only builds interaction lists; the passes over them are split
+ * into pool blocks by target cell, so every sum runs in a fixed order and results do not depend on
+ * the thread count.
+ */
+template<int P>
+class FastMultipole {
+    public:
+        typedef std::complex<double> Coefficient;
+        typedef struct {
+            Coefficient terms[P * P]; //terms[k * P + l]
+        }Expansion;
+
+        FastMultipole(unsigned int leafSize = FMM_LEAF_SIZE);
+        //The near field runs the kernel's force law, the far field is that law beyond its farField
+        void calculateAccelerations(ParticleSystem& particles, float theta, const ForceKernel& kernel, const ForceParams& params, ThreadPool* pool);
+    private:
+        QuadTree tree;
+        ForceKernel kernel;
+        ForceParams params;
+        float minSeparation; //Closest bodies of two cells for the far field
+        std::vector<float> sortedX, sortedY, sortedMass, sortedAx, sortedAy; //In tree order
+        std::vector<Expansion> multipoles;
+        std::vector<Expansion> locals;
+        std::vector<double> radius; //Of the bodies around the node's center of mass
+        std::vector<int> parent;
+        std::vector<std::vector<int>> levels; //Nodes by depth
+        std::vector<int> leaves;
+        //Interaction lists by target node, sources of node n are [start[n], start[n + 1])
+        std::vector<int> m2lStart, m2lSources, p2pStart, p2pSources;
+        std::vector<std::pair<int, int>> m2lPairs, p2pPairs; //(target, source) as the walk finds them
+        void buildLevels();
+        void upward(const ParticleSystem& particles, ThreadPool* pool);
+        void interact(int a, int b, float theta);
+        void downward(ParticleSystem& particles, ThreadPool* pool);
+};
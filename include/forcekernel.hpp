@@ -0,0 +1,88 @@
+#pragma once
+#include <cstddef>
+#include "forcelaw.hpp"
+
+/*
+ * Direct sum force kernels, one per instruction set and force law, chosen at startup from the CPU
+ * features and switched with the law. Each is a template instance for its law (forcelaw.hpp), the
+ * laws only meet at the function pointer.
+ *
+ * A kernel adds the accelerations of every pair (i, j) with begin <= i < end and i < j < count
+ * to both bodies (Newton's third law), so calling it over [0, count) gives the full sum.
+ * The cutoff law is done with masks instead of a branch, Plummer softening needs neither.
+ *
+ * Tolerance: every ISA evaluates each pair with the same IEEE operations in the same order
+ * (exact sqrt and division, no FMA contraction), so per pair terms are bitwise identical to the
+ * scalar kernel. Only the order in which a row's partner terms are summed differs (4, 8 or 16
+ * partial sums reduced at the end of the row). Accelerations typically match the scalar kernel to
+ * a relative 1e-6, and stay within 1e-4 for bodies whose net force nearly cancels.
+ *
+ * A source sum kernel is one sided: bodies begin <= i < end get the pull of every body
+ * sourceBegin <= j < sourceEnd and sources are left untouched, for tree codes whose near field
+ * pairs are not symmetric. The ranges may overlap, a body never pulls itself because a zero
+ * distance gives no force under either law.
+ */
+
+typedef void (*DirectSumKernel)(const ForceParams& params, const float* x, const float* y, const float* mass, float* ax, float* ay, size_t begin, size_t end, size_t count);
+typedef void (*SourceSumKernel)(const ForceParams& params, const float* x, const float* y, const float* mass, float* ax, float* ay, size_t begin, size_t end, size_t sourceBegin, size_t sourceEnd);
+
+enum class KernelIsa {
+    Scalar,
+    SSE2,
+    AVX2,
+    AVX512
+};
+
+typedef struct {
+    KernelIsa isa;
+    ForceLaw law;
+    const char* name;
+    DirectSumKernel directSum;
+    SourceSumKernel sourceSum;
+}ForceKernel;
+
+//Best kernel the CPU supports
+ForceKernel selectForceKernel(ForceLaw law = ForceLaw::NewtonCutoff);
+//Kernel for a specific instruction set, returns false and leaves kernel unchanged if it is not compiled in or not supported
+bool getForceKernel(KernelIsa isa, ForceKernel& kernel, ForceLaw law = ForceLaw::NewtonCutoff);
+
+//Instantiated for NewtonCutoff and Plummer by each instruction set's translation unit
+template<class Law> void directSumScalar(const ForceParams& params, const float* x, const float* y, const float* mass, float* ax, float* ay, size_t begin, size_t end, size_t count);
+template<class Law> void sourceSumScalar(const ForceParams& params, const float* x, const float* y, const float* mass, float* ax, float* ay, size_t begin, size_t end, size_t sourceBegin, size_t sourceEnd);
+#ifdef FORCE_KERNEL_X86
+template<class Law> void directSumSSE2(const ForceParams& params, const float* x, const float* y, const float* mass, float* ax, float* ay, size_t begin, size_t end, size_t count);
+template<class Law> void sourceSumSSE2(const ForceParams& params, const float* x, const float* y, const float* mass, float* ax, float* ay, size_t begin, size_t end, size_t sourceBegin, size_t sourceEnd);
+template<class Law> void directSumAVX2(const ForceParams& params, const float* x, const float* y, const float* mass, float* ax, float* ay, size_t begin, size_t end, size_t count);
+template<class Law> void sourceSumAVX2(const ForceParams& params, const float* x, const float* y, const float* mass, float* ax, float* ay, size_t begin, size_t end, size_t sourceBegin, size_t sourceEnd);
+template<class Law> void directSumAVX512(const ForceParams& params, const float* x, const float* y, const float* mass, float* ax, float* ay, size_t begin, size_t end, size_t count);
+template<class Law> void sourceSumAVX512(const ForceParams& params, const float* x, const float* y, const float* mass, float* ax, float* ay, size_t begin, size_t end, size_t sourceBegin, size_t sourceEnd);
+#endif
+
+/*
+ * One pair in scalar code, shared by the scalar kernel and the SIMD remainder loops. The square
+ * root comes from Ops::scalarSqrt so the SIMD translation units never instantiate an inline
+ * std:: function with their wider target flags.
+ */
+template<class Ops, class Law>
+void directSumPair(const ForceParams& params, const float* x, const float* y, const float* mass, float* ax, float* ay, size_t i, size_t j, float& rowX, float& rowY){
+    float dx = x[j] - x[i];
+    float dy = y[j] - y[i];
+    float scale = Law::template scalar<Ops>(params, dx * dx + dy * dy);
+    float scaleJ = scale * mass[j];
+    float scaleI = scale * mass[i];
+    rowX = rowX + dx * scaleJ;
+    rowY = rowY + dy * scaleJ;
+    ax[j] = ax[j] - dx * scaleI;
+    ay[j] = ay[j] - dy * scaleI;
+}
+
+//One sided pair, only body i is pulled
+template<class Ops, class Law>
+void sourceSumPair(const ForceParams& params, const float* x, const float* y, const float* mass, size_t i, size_t j, float& rowX, float& rowY){
+    float dx = x[j] - x[i];
+    float dy = y[j] - y[i];
+    float scale = Law::template scalar<Ops>(params, dx * dx + dy * dy);
+    float scaleJ = scale * mass[j];
+    rowX = rowX + dx * scaleJ;
+    rowY = rowY + dy * scaleJ;
+}
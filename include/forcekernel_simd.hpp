@@ -0,0 +1,79 @@
+#pragma once
+#include "forcekernel.hpp"
+
+/*
+ * Direct sum kernel written once against an instruction set wrapper (Ops). Only included by the
+ * per ISA translation units, which compile it with their own target flags inside an anonymous
+ * namespace so no symbol built with wider instructions can leak into the rest of the program.
+ *
+ * Ops provides: Vec, Mask, width, set1, zero, loadu, storeu, add, sub, mul, div, sqrt,
+ * greaterEqual (Mask), maskedDiv (a / b where the mask is set, 0 elsewhere), reduce and scalarSqrt.
+ * The force law (Law::Simd) turns squared distances into pair scales with them.
+ */
+template<class Ops, class Law>
+void directSumSimd(const ForceParams& params, const float* x, const float* y, const float* mass, float* ax, float* ay, size_t begin, size_t end, size_t count){
+    typedef typename Ops::Vec Vec;
+    const typename Law::template Simd<Ops> law(params);
+
+    for(size_t i = begin; i < end; i++){
+        const Vec xi = Ops::set1(x[i]);
+        const Vec yi = Ops::set1(y[i]);
+        const Vec mi = Ops::set1(mass[i]);
+        Vec sumX = Ops::zero();
+        Vec sumY = Ops::zero();
+
+        size_t j = i + 1;
+        for(; j + Ops::width <= count; j += Ops::width){
+            Vec dx = Ops::sub(Ops::loadu(x + j), xi);
+            Vec dy = Ops::sub(Ops::loadu(y + j), yi);
+            Vec scale = law.scale(Ops::add(Ops::mul(dx, dx), Ops::mul(dy, dy)));
+
+            Vec scaleJ = Ops::mul(scale, Ops::loadu(mass + j));
+            Vec scaleI = Ops::mul(scale, mi);
+            sumX = Ops::add(sumX, Ops::mul(dx, scaleJ));
+            sumY = Ops::add(sumY, Ops::mul(dy, scaleJ));
+            Ops::storeu(ax + j, Ops::sub(Ops::loadu(ax + j), Ops::mul(dx, scaleI)));
+            Ops::storeu(ay + j, Ops::sub(Ops::loadu(ay + j), Ops::mul(dy, scaleI)));
+        }
+
+        float rowX = Ops::reduce(sumX);
+        float rowY = Ops::reduce(sumY);
+        for(; j < count; j++){
+            directSumPair<Ops, Law>(params, x, y, mass, ax, ay, i, j, rowX, rowY);
+        }
+        ax[i] += rowX;
+        ay[i] += rowY;
+    }
+}
+
+template<class Ops, class Law>
+void sourceSumSimd(const ForceParams& params, const float* x, const float* y, const float* mass, float* ax, float* ay, size_t begin, size_t end, size_t sourceBegin, size_t sourceEnd){
+    typedef typename Ops::Vec Vec;
+    const typename Law::template Simd<Ops> law(params);
+
+    for(size_t i = begin; i < end; i++){
+        const Vec xi = Ops::set1(x[i]);
+        const Vec yi = Ops::set1(y[i]);
+        Vec sumX = Ops::zero();
+        Vec sumY = Ops::zero();
+
+        size_t j = sourceBegin;
+        for(; j + Ops::width <= sourceEnd; j += Ops::width){
+            Vec dx = Ops::sub(Ops::loadu(x + j), xi);
+            Vec dy = Ops::sub(Ops::loadu(y + j), yi);
+            Vec scale = law.scale(Ops::add(Ops::mul(dx, dx), Ops::mul(dy, dy)));
+
+            Vec scaleJ = Ops::mul(scale, Ops::loadu(mass + j));
+            sumX = Ops::add(sumX, Ops::mul(dx, scaleJ));
+            sumY = Ops::add(sumY, Ops::mul(dy, scaleJ));
+        }
+
+        float rowX = Ops::reduce(sumX);
+        float rowY = Ops::reduce(sumY);
+        for(; j < sourceEnd; j++){
+            sourceSumPair<Ops, Law>(params, x, y, mass, i, j, rowX, rowY);
+        }
+        ax[i] += rowX;
+        ay[i] += rowY;
+    }
+}
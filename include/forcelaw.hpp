@@ -0,0 +1,108 @@
+#pragma once
+#include <cmath>
+
+#define PLUMMER_SOFTENING 10.0f //Default softening length, half of MIN_DISTANCE_THRESHOLD
+#define PLUMMER_FAR_FIELD 8.0f //Softening lengths beyond which the unsoftened law is used for far cells
+
+enum class ForceLaw {
+    NewtonCutoff, //1/r^2, no force closer than minDistance
+    Plummer //r / (r^2 + eps^2)^(3/2), smooth everywhere
+};
+
+typedef struct {
+    float g;
+    float minDistance; //NewtonCutoff: pairs closer than this feel no force
+    float softeningSquared; //Plummer: eps^2, must be above 0
+}ForceParams;
+
+//Square root for the laws outside the SIMD translation units, which bring their own Ops
+struct ScalarOps {
+    static float scalarSqrt(float value){ return std::sqrt(value); }
+};
+
+/*
+ * Force laws as compile time policies, so every kernel and tree walk is specialized for its law and
+ * the inner loops carry no dispatch. Body i is pulled towards body j by (dx, dy) * scale * m_j, with
+ * scale a function of the squared distance alone:
+ *   scalar<Ops>(params, r^2)  one pair, the square root from Ops::scalarSqrt (see forcekernel.hpp)
+ *   Simd<Ops>(params).scale(r^2)  a vector of pairs, constants broadcast once per kernel call
+ *   potential(params, r^2)  pair potential per unit masses, for energies and the mesh Green's function
+ *   farField(params)  closest separation at which far cells may use unsoftened 1/r^2 expansions
+ *
+ * The cutoff law needs a compare and a masked divide; Plummer softening is branch free and keeps the
+ * force continuous, so close encounters no longer kick bodies when they cross the threshold. A body
+ * still never pulls itself: dx = dy = 0 gives a zero force under both laws.
+ */
+struct NewtonCutoff {
+    static const ForceLaw law = ForceLaw::NewtonCutoff;
+
+    template<class Ops>
+    static float scalar(const ForceParams& params, float distanceSquared){
+        float distance = Ops::scalarSqrt(distanceSquared);
+        return distance >= params.minDistance ? params.g / (distanceSquared * distance) : 0.0f;
+    }
+
+    template<class Ops>
+    struct Simd {
+        typename Ops::Vec g;
+        typename Ops::Vec minDistance;
+        explicit Simd(const ForceParams& params) : g(Ops::set1(params.g)), minDistance(Ops::set1(params.minDistance)){}
+        typename Ops::Vec scale(typename Ops::Vec distanceSquared) const{
+            typename Ops::Vec distance = Ops::sqrt(distanceSquared);
+            typename Ops::Mask outside = Ops::greaterEqual(distance, this->minDistance);
+            return Ops::maskedDiv(outside, this->g, Ops::mul(distanceSquared, distance));
+        }
+    };
+
+    //No force inside the threshold means a flat potential there
+    static double potential(const ForceParams& params, double distanceSquared){
+        return -params.g / std::fmax(std::sqrt(distanceSquared), (double)params.minDistance);
+    }
+
+    static float farField(const ForceParams& params){
+        return params.minDistance;
+    }
+};
+
+struct Plummer {
+    static const ForceLaw law = ForceLaw::Plummer;
+
+    template<class Ops>
+    static float scalar(const ForceParams& params, float distanceSquared){
+        float softened = distanceSquared + params.softeningSquared;
+        return params.g / (softened * Ops::scalarSqrt(softened));
+    }
+
+    template<class Ops>
+    struct Simd {
+        typename Ops::Vec g;
+        typename Ops::Vec softeningSquared;
+        explicit Simd(const ForceParams& params) : g(Ops::set1(params.g)), softeningSquared(Ops::set1(params.softeningSquared)){}
+        typename Ops::Vec scale(typename Ops::Vec distanceSquared) const{
+            typename Ops::Vec softened = Ops::add(distanceSquared, this->softeningSquared);
+            return Ops::div(this->g, Ops::mul(softened, Ops::sqrt(softened)));
+        }
+    };
+
+    static double potential(const ForceParams& params, double distanceSquared){
+        return -params.g / std::sqrt(distanceSquared + params.softeningSquared);
+    }
+
+    //The softened force is 1.5 eps^2 / r^2 (relative) below 1/r^2, about 2% at 8 eps
+    static float farField(const ForceParams& params){
+        return PLUMMER_FAR_FIELD * std::sqrt(params.softeningSquared);
+    }
+};
+
+//Runtime counterparts for code outside the inner loops (Green's function tables, acceptance criteria)
+inline double forcePotential(ForceLaw law, const ForceParams& params, double distanceSquared){
+    return law == ForceLaw::Plummer ? Plummer::potential(params, distanceSquared) : NewtonCutoff::potential(params, distanceSquared);
+}
+
+inline float forceFarField(ForceLaw law, const ForceParams& params){
+    return law == ForceLaw::Plummer ? Plummer::farField(params) : NewtonCutoff::farField(params);
+}
+
+inline const char* forceLawName(ForceLaw law){
+    return law == ForceLaw::Plummer ? "Plummer softening" : "Newton with cutoff";
+}
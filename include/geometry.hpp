@@ -0,0 +1,23 @@
+#pragma once
+#include <vector>
+#include "utils.hpp"
+
+/*
+ * Mesh generation for the shapes, plain vectors with no OpenGL so it can be benchmarked and
+ * reused without a context. Vertices are x, y, z triples.
+ */
+
+#define PI 3.14159265358979323846
+
+#define CIRCLE_LOD_COUNT 5 //Circle meshes of 8, 16, 32, 64 and 128 segments
+#define CIRCLE_LOD_MIN_SEGMENTS 8
+#define CIRCLE_LOD_TOLERANCE 0.25f //Pixels the rim may fall inside the true circle
+
+//Triangle fan as a center vertex plus numElements rim vertices
+std::vector<float> circleVertices(Pos pos, float radius, unsigned int numElements);
+std::vector<unsigned int> circleIndices(unsigned int numElements);
+
+//Segments of a level of detail, CIRCLE_LOD_MIN_SEGMENTS doubled per level
+unsigned int circleLodSegments(unsigned int lod);
+//Coarsest level whose rim stays within CIRCLE_LOD_TOLERANCE of a circle pixelRadius pixels across
+unsigned int circleLod(float pixelRadius);
@@ -0,0 +1,33 @@
+#pragma once
+#include <glad/glad.h>
+
+/*
+ * Remembers the bound program, vertex array and buffers so redundant binds never reach the driver.
+ * Every bind and delete of those objects has to go through the cache, or it must be invalidated.
+ * The element array binding belongs to the vertex array, so it is forgotten when the VAO changes.
+ */
+class GLStateCache {
+    public:
+        GLStateCache();
+        void useProgram(unsigned int program);
+        void bindVertexArray(unsigned int vao);
+        void bindBuffer(GLenum target, unsigned int buffer);
+        void deleteVertexArray(unsigned int vao);
+        void deleteBuffer(unsigned int buffer);
+        void deleteProgram(unsigned int program);
+        void invalidate();
+        //Call at the start of every frame, the counters then report the previous frame
+        void beginFrame();
+        unsigned int getLastFrameIssuedCalls() const;
+        unsigned int getLastFrameSkippedCalls() const;
+    private:
+        unsigned int program;
+        unsigned int vao;
+        unsigned int arrayBuffer;
+        unsigned int elementBuffer;
+        bool elementBufferKnown;
+        unsigned int issuedCalls;
+        unsigned int skippedCalls;
+        unsigned int lastFrameIssuedCalls;
+        unsigned int lastFrameSkippedCalls;
+};
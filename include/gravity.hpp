@@ -0,0 +1,56 @@
+#pragma once
+#include <vector>
+#include "fmm.hpp"
+#include "forcekernel.hpp"
+#include "forcelaw.hpp"
+#include "particlemesh.hpp"
+#include "particlesystem.hpp"
+#include "quadtree.hpp"
+#include "threadpool.hpp"
+#include "vector2d.hpp"
+
+#define BARNES_HUT_THETA 0.5f
+#define BARNES_HUT_MAX_THETA 1.0f //Wider angles can accept a node holding the body itself, which then pulls on itself
+#define PARALLEL_MIN_BODIES 1024 //Below this the force pass runs on the calling thread
+#define BARNES_HUT_BLOCK 256 //Bodies per thread pool block
+
+enum class ForceSolver {
+    DirectSum,
+    BarnesHut,
+    ParticleMesh,
+    FastMultipole
+};
+
+class GravitySolver {
+    public:
+        ForceSolver solver;
+        float theta; //Barnes-Hut and multipole opening angle, 0 degrades to direct sum
+        ForceKernel kernel; //Direct sum kernel for the CPU we run on and the force law
+        GravitySolver(ForceSolver solver, float theta, ThreadPool* pool = nullptr);
+        void calculateAccelerations(ParticleSystem& particles);
+        const char* getName();
+        //Every solver follows the law, softening is the Plummer eps
+        void setForceLaw(ForceLaw law, float softening = PLUMMER_SOFTENING);
+        ForceLaw getForceLaw() const;
+        float getSoftening() const;
+        ForceParams getForceParams() const;
+        //Kinetic plus potential energy, O(N^2) so meant for diagnostics
+        double calculateEnergy(const ParticleSystem& particles);
+    private:
+        ThreadPool* pool;
+        ForceParams params;
+        float softening; //Kept as given so checkpoints restore it exactly, params only hold its square
+        QuadTree tree;
+        ParticleMesh mesh;
+        FastMultipole<FMM_ORDER> multipole;
+        std::vector<std::vector<int>> stacks; //Tree walk stack per thread
+        std::vector<std::vector<float>> accumulatorX; //Direct sum accumulator per row block
+        std::vector<std::vector<float>> accumulatorY;
+        std::vector<size_t> rowStart;
+        void directSum(ParticleSystem& particles);
+        void barnesHut(ParticleSystem& particles);
+        template<class Law>
+        void barnesHutWalk(ParticleSystem& particles);
+        template<class Law>
+        double potentialEnergy(const ParticleSystem& particles);
+};
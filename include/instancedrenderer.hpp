@@ -0,0 +1,69 @@
+#pragma once
+#include <glad/glad.h>
+#include <cstddef>
+#include <vector>
+#include <glm/glm.hpp>
+#include "geometry.hpp"
+#include "glstate.hpp"
+#include "shader.hpp"
+#include "utils.hpp"
+
+//Per body data streamed to the GPU every frame
+typedef struct {
+    float x;
+    float y;
+    float radius;
+    float r;
+    float g;
+    float b;
+}CircleInstance;
+
+/*
+ * Draws every circle with one glDrawElementsInstanced call per level of detail. Unit circle meshes
+ * of every level are uploaded once into one buffer; each frame the circles are bucketed by the
+ * level their size on screen needs, so vertex work follows what is visible instead of the largest
+ * body. The position, radius and color of each circle come from a per instance buffer.
+ */
+class InstancedCircleRenderer {
+    public:
+        std::vector<CircleInstance> instances; //Filled by the caller each frame
+        InstancedCircleRenderer(const ShaderProgram& shader, GLStateCache& state);
+        ~InstancedCircleRenderer();
+        void clear();
+        void add(float x, float y, float radius, RGB color);
+        //pixelSize: world units per pixel along x and y, picks each circle's level of detail
+        void render(const glm::mat4& camera, const glm::vec2& pixelSize);
+    private:
+        const ShaderProgram* shader;
+        GLStateCache* state;
+        int cameraLocation, offsetLocation, radiusLocation, colorLocation;
+        unsigned int vao, meshVbo, ebo, instanceVbo;
+        unsigned int lodFirstIndex[CIRCLE_LOD_COUNT];
+        unsigned int lodIndexCount[CIRCLE_LOD_COUNT];
+        size_t instanceCapacity;
+        std::vector<CircleInstance> sorted; //instances grouped by level of detail
+        std::vector<unsigned char> lods;
+};
+
+/*
+ * Draws every circle as an instanced quad, four corners in place of a 65 vertex fan. The fragment
+ * shader shades the disc from its signed distance to the edge, anti-aliased over one pixel at any
+ * zoom, so nothing is tessellated and a body costs the same however large it is on screen.
+ * Needs blending (GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA) for the soft edge.
+ */
+class SdfCircleRenderer {
+    public:
+        std::vector<CircleInstance> instances; //Filled by the caller each frame
+        SdfCircleRenderer(const ShaderProgram& shader, GLStateCache& state);
+        ~SdfCircleRenderer();
+        void clear();
+        void add(float x, float y, float radius, RGB color);
+        //pixelSize: world units per pixel along x and y, for the edge margin
+        void render(const glm::mat4& camera, const glm::vec2& pixelSize);
+    private:
+        const ShaderProgram* shader;
+        GLStateCache* state;
+        int cameraLocation, pixelSizeLocation;
+        unsigned int vao, cornerVbo, instanceVbo;
+        size_t instanceCapacity;
+};
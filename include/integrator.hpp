@@ -0,0 +1,67 @@
+#pragma once
+#include <memory>
+#include "gravity.hpp"
+#include "particlesystem.hpp"
+
+enum class IntegratorType {
+    Euler,
+    Leapfrog,
+    VelocityVerlet,
+    Yoshida4
+};
+
+/*
+ * Advances positions and velocities by one step. Forces only come from GravitySolver, which leaves
+ * accelerations in particles.ax/ay, so integrators never compute forces themselves.
+ *
+ * The symplectic integrators reuse the accelerations left over from the previous step for their
+ * first kick. Call reset() whenever bodies are added, removed or changed outside of step().
+ */
+class Integrator {
+    public:
+        virtual ~Integrator(){}
+        virtual void step(ParticleSystem& particles, GravitySolver& solver, float dt) = 0;
+        virtual const char* getName() const = 0;
+        virtual IntegratorType getType() const = 0;
+        void reset();
+        bool primed; //particles.ax/ay hold the accelerations of the current positions
+    protected:
+        Integrator();
+        void prime(ParticleSystem& particles, GravitySolver& solver);
+        void kick(ParticleSystem& particles, float dt);
+        void drift(ParticleSystem& particles, float dt);
+};
+
+//Semi-implicit Euler, first order, kept for comparison with the old update
+class EulerIntegrator : public Integrator {
+    public:
+        void step(ParticleSystem& particles, GravitySolver& solver, float dt) override;
+        const char* getName() const override;
+        IntegratorType getType() const override;
+};
+
+//Kick-drift-kick leapfrog, second order, one force evaluation per step
+class LeapfrogIntegrator : public Integrator {
+    public:
+        void step(ParticleSystem& particles, GravitySolver& solver, float dt) override;
+        const char* getName() const override;
+        IntegratorType getType() const override;
+};
+
+//Velocity Verlet, second order, positions advanced from velocity and acceleration together
+class VelocityVerletIntegrator : public Integrator {
+    public:
+        void step(ParticleSystem& particles, GravitySolver& solver, float dt) override;
+        const char* getName() const override;
+        IntegratorType getType() const override;
+};
+
+//Yoshida / Forest-Ruth fourth order, three leapfrog substeps per step (three force evaluations)
+class Yoshida4Integrator : public Integrator {
+    public:
+        void step(ParticleSystem& particles, GravitySolver& solver, float dt) override;
+        const char* getName() const override;
+        IntegratorType getType() const override;
+};
+
+std::unique_ptr<Integrator> createIntegrator(IntegratorType type);
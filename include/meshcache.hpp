@@ -0,0 +1,55 @@
+#pragma once
+#include <glad/glad.h>
+#include <functional>
+#include <map>
+#include <tuple>
+#include <vector>
+#include "glstate.hpp"
+#include "shader.hpp"
+
+enum class MeshType {
+    Square, //Side 1
+    Triangle, //Side 1
+    Circle //Radius 1, the parameter is the segment count
+};
+
+//GPU buffers of one unit mesh, the vertex array binds them to a program's aPos
+typedef struct {
+    unsigned int vao;
+    unsigned int vbo;
+    unsigned int ebo;
+    unsigned int indexCount;
+    unsigned int references;
+    unsigned int program; //Program, type and parameter are the mesh's key in its cache
+    MeshType type;
+    unsigned int parameter;
+}Mesh;
+
+/*
+ * Uploads each distinct unit mesh once and hands the same buffers to every shape that asks for it,
+ * so GPU and host memory grow with the number of different meshes rather than with the number of
+ * shapes. Shapes differ only in their transform. Vertices and indices are built on the first
+ * request, uploaded and dropped; nothing stays on the CPU.
+ *
+ * Meshes are reference counted: the last release deletes the buffers. A mesh that should stay
+ * built, like the circle levels of detail the app makes at startup, keeps a reference that is
+ * never released. The cache must outlive every shape using it and the GL context must outlive the cache.
+ */
+class MeshCache {
+    public:
+        MeshCache(GLStateCache& state);
+        ~MeshCache();
+        MeshCache(const MeshCache&) = delete;
+        MeshCache& operator=(const MeshCache&) = delete;
+        //build fills x, y, z vertices and triangle indices, only called when the mesh is not cached yet
+        const Mesh* acquire(MeshType type, unsigned int parameter, const ShaderProgram& shader,
+                            const std::function<void(std::vector<float>&, std::vector<unsigned int>&)>& build);
+        void release(const Mesh* mesh);
+        GLStateCache& getState();
+        size_t size() const; //Distinct meshes alive
+    private:
+        typedef std::tuple<unsigned int, int, unsigned int> Key; //Program (its attribute layout), type, parameter
+        GLStateCache* state;
+        std::map<Key, Mesh> meshes;
+        void destroy(Mesh& mesh);
+};
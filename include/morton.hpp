@@ -0,0 +1,40 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "particlesystem.hpp"
+
+#define MORTON_BITS 16 //Per axis, cells of the bounding box are 1/65536 of its side
+#define MORTON_RADIX_BITS 8
+
+//Interleaves the bits of x and y, x in the even bits
+inline uint32_t mortonCode(uint32_t x, uint32_t y){
+    auto spread = [](uint32_t v){
+        v &= 0x0000FFFF;
+        v = (v | (v << 8)) & 0x00FF00FF;
+        v = (v | (v << 4)) & 0x0F0F0F0F;
+        v = (v | (v << 2)) & 0x33333333;
+        v = (v | (v << 1)) & 0x55555555;
+        return v;
+    };
+    return spread(x) | (spread(y) << 1);
+}
+
+/*
+ * Reorders every body array along the Z-order curve of the bodies' bounding box, so bodies that are
+ * close in space are close in memory and tree walks touch far fewer cache lines. LSD radix sort on
+ * the 32 bit codes, stable, so bodies in the same cell keep their order and the result does not
+ * depend on anything but the positions. Scratch space is kept between sorts.
+ *
+ * Indices change, ParticleSystem::ids and indexOf follow bodies across a sort.
+ */
+class MortonSorter {
+    public:
+        void sort(ParticleSystem& particles);
+    private:
+        std::vector<uint32_t> codes, codeScratch;
+        std::vector<int> order, orderScratch; //order[i] is the old index of the body that moves to i
+        std::vector<float> floatScratch;
+        std::vector<unsigned int> idScratch;
+        std::vector<Planet> planetScratch;
+        void gather(std::vector<float>& values);
+};
@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+#include "fft.hpp"
+#include "forcelaw.hpp"
+#include "particlesystem.hpp"
+#include "threadpool.hpp"
+
+#define PM_GRID_SIZE 256 //Cells per side, a power of two
+#define PM_MAX_DOUBLINGS 10 //The mesh grows up to SIM_SIZE * 2^10 to hold escaping bodies
+
+/*
+ * Particle-mesh gravity: cloud-in-cell mass deposition onto a grid, the potential from an FFT
+ * convolution, and central difference forces interpolated back with the same cloud-in-cell weights.
+ *
+ * The grid is centered on the origin and covers [-L, L] with L = SIM_SIZE * 2^k, the smallest k
+ * that holds every body, so the Green's function only changes when the mesh grows or shrinks or the
+ * force law changes.
+ * Bodies beyond the largest mesh feel no mesh force and add no mass.
+ *
+ * Our force is the planar 1/r^2 law, not the 2D Poisson (1/r) one, so rather than dividing by k^2
+ * the density is convolved with the force law's pair potential (-G / max(r, minDistance) or
+ * -G / sqrt(r^2 + eps^2)), the same potential calculateEnergy uses. Both are zero padded to twice the grid (Hockney's method) so the
+ * convolution is free space instead of periodic. Forces are smoothed below about two cells.
+ */
+class ParticleMesh {
+    public:
+        ParticleMesh(unsigned int gridSize = PM_GRID_SIZE);
+        void calculateAccelerations(ParticleSystem& particles, ForceLaw law, const ForceParams& params, ThreadPool* pool);
+        float getCellSize() const;
+    private:
+        unsigned int gridSize;
+        float halfSize; //Of the current mesh, 0 before the first pass
+        ForceLaw law; //Of the current Green's function
+        ForceParams params;
+        FFT2D fft; //Over the padded grid
+        std::vector<Complex> greens; //Spectrum of the padded Green's function for halfSize
+        std::vector<Complex> padded;
+        std::vector<std::vector<float>> blockMass; //Deposition grid per body block
+        std::vector<float> potential;
+        void buildGreens(ThreadPool* pool);
+        void deposit(const ParticleSystem& particles, ThreadPool* pool);
+        void interpolate(ParticleSystem& particles, ThreadPool* pool);
+};
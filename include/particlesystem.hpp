@@ -0,0 +1,35 @@
+#pragma once
+#include <string>
+#include <vector>
+#include "planet.hpp"
+#include "utils.hpp"
+#include "vector2d.hpp"
+
+//Structure of arrays body storage, index i of every array belongs to the same body
+class ParticleSystem {
+    public:
+        //Hot data, streamed by the force and integration loops
+        std::vector<float> x;
+        std::vector<float> y;
+        std::vector<float> vx;
+        std::vector<float> vy;
+        std::vector<float> ax;
+        std::vector<float> ay;
+        std::vector<float> mass;
+        //Positions before the last step, for render interpolation
+        std::vector<float> prevX;
+        std::vector<float> prevY;
+        //Cold data (name, color, render handle) in a side table
+        std::vector<Planet> planets;
+        //Stable id of each body, indices change when bodies are sorted or removed
+        std::vector<unsigned int> ids;
+        //Index of every id handed out, -1 once the body is removed
+        std::vector<int> slots;
+        size_t addBody(std::string name, float mass, Vector2D pos, Vector2D velocity, RGB color);
+        //Swap and pop, the last body takes index i so only indices past it change
+        void removeBody(size_t i);
+        size_t size() const;
+        //Current index of a body, -1 if it was removed
+        int indexOf(unsigned int id) const;
+        void reserve(size_t count);
+};
@@ -1,28 +1,23 @@
+#pragma once
 #include <string>
 #include <vector>
 #include <cmath>
-#include "app.hpp"
-#include "shape.hpp"
+#include "utils.hpp"
 #include "vector2d.hpp"
 
 #define G_CONST 1e-2
 #define SIM_SIZE 1000.0f
 #define MIN_DISTANCE_THRESHOLD 20.0f
 
-extern OpenGLApp app;
-
-typedef struct {
-    float x;
-    float y;
-}PlanetPos;
+//Bodies are discs of constant density, used for drawing and collisions
+inline float bodyRadius(float mass){
+    return std::sqrt(mass);
+}
 
+//Cold per body data, kept out of the arrays the physics loops stream through
 class Planet {
     public:
         std::string name;
-        float mass;
-        Vector2D position;
-        Vector2D velocity;
-        Planet(std::string name, float mass, Vector2D pos, RGB color);
-        Vector2D calculateGravityForce(const Planet& other);
-        Circle* circle;
+        RGB color;
+        Planet(std::string name, RGB color);
 };
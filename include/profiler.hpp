@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <string>
+
+/*
+ * Scoped timing zones. PROFILE_ZONE("name") records the time from that line to the end of the
+ * enclosing scope into a ring buffer owned by the calling thread, the last PROFILER_RING_SIZE zones
+ * of every thread are kept. Names must be string literals, only the pointer is stored.
+ *
+ * Zones only exist when built with ENABLE_PROFILER (cmake -DENABLE_PROFILER=ON), otherwise the
+ * macro expands to nothing and writeChromeTrace fails.
+ */
+
+#define PROFILER_RING_SIZE (1 << 16) //Zones kept per thread, a power of two
+
+#ifdef ENABLE_PROFILER
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#define PROFILER_RDTSC
+#endif
+
+//Raw timestamp, TSC cycles on x86 and steady clock nanoseconds elsewhere
+uint64_t profilerClockFallback();
+inline uint64_t profilerTicks(){
+#ifdef PROFILER_RDTSC
+    return __rdtsc();
+#else
+    return profilerClockFallback();
+#endif
+}
+
+void recordProfileZone(const char* name, uint64_t start, uint64_t end);
+
+class ProfileZone {
+    public:
+        ProfileZone(const char* name){
+            this->name = name;
+            this->start = profilerTicks();
+        }
+        ~ProfileZone(){
+            recordProfileZone(this->name, this->start, profilerTicks());
+        }
+    private:
+        const char* name;
+        uint64_t start;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_ZONE(name) ProfileZone PROFILE_CONCAT(profileZone, __LINE__)(name)
+
+#else
+
+#define PROFILE_ZONE(name)
+
+#endif
+
+//Names the calling thread in exported traces
+void setProfilerThreadName(const std::string& name);
+/*
+ * Writes every recorded zone as Chrome trace event JSON (chrome://tracing, ui.perfetto.dev).
+ * Zones still open are not included. Call it while the other threads are idle, between frames or
+ * between pool runs, so no ring is written during the copy.
+ */
+bool writeChromeTrace(const std::string& path);
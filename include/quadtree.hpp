@@ -0,0 +1,35 @@
+#pragma once
+#include <vector>
+#include "forcelaw.hpp"
+#include "particlesystem.hpp"
+#include "vector2d.hpp"
+
+#define QUADTREE_MAX_DEPTH 32
+
+//A node of the tree, children are stored as four consecutive nodes starting at firstChild
+typedef struct {
+    float centerX;
+    float centerY;
+    float halfSize;
+    float mass;
+    float comX; //Center of mass
+    float comY;
+    int firstChild; //-1 for leaves
+    int begin; //Range of bodies in QuadTree::order
+    int count;
+}QuadNode;
+
+class QuadTree {
+    public:
+        std::vector<QuadNode> nodes;
+        std::vector<int> order; //Body indices grouped so every node owns a contiguous range
+        unsigned int leafSize;
+        QuadTree(unsigned int leafSize = 1);
+        void build(const ParticleSystem& particles);
+        //Safe to call from several threads as long as each passes its own stack, Law is NewtonCutoff or Plummer
+        template<class Law>
+        Vector2D calculateAcceleration(const ParticleSystem& particles, int index, float theta, const ForceParams& params, std::vector<int>& stack) const;
+    private:
+        std::vector<int> scratch;
+        void split(const ParticleSystem& particles, int node, int depth);
+};
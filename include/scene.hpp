@@ -0,0 +1,7 @@
+#pragma once
+#include "particlesystem.hpp"
+
+//The sun, earth, moon and jupiter
+void loadSolarSystem(ParticleSystem& particles);
+//A central sun with count bodies on near circular orbits around it
+void loadDisk(ParticleSystem& particles, size_t count, unsigned int seed);
@@ -0,0 +1,16 @@
+#pragma once
+#include <glad/glad.h>
+#include <string>
+#include <unordered_map>
+
+//A linked program with every active uniform and attribute location looked up once after linking
+class ShaderProgram {
+    public:
+        unsigned int id;
+        ShaderProgram(unsigned int id = 0);
+        int getUniformLocation(const std::string& name) const; //-1 if the program has no such uniform
+        int getAttributeLocation(const std::string& name) const;
+    private:
+        std::unordered_map<std::string, int> uniforms;
+        std::unordered_map<std::string, int> attributes;
+};
@@ -1,55 +1,75 @@
 #pragma once
 #include <glad/glad.h>
 #include <GLFW/glfw3.h>
+#include <functional>
 #include <vector>
 #include <cmath>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
+#include "geometry.hpp"
+#include "glstate.hpp"
+#include "meshcache.hpp"
+#include "shader.hpp"
 #include "utils.hpp"
 
-#define PI 3.14159265358979323846
+//Where a shape's unit mesh goes: rotated, then scaled, then moved to the position
+typedef struct {
+    float x;
+    float y;
+    float rotation; //Radians, counterclockwise
+    float scale;
+}Transform2D;
 
+/*
+ * A unit mesh from the MeshCache placed by a Transform2D. The vertex shader composes the transform
+ * with the camera, so a draw uploads four floats and a color; the camera is set once per frame
+ * with setCamera. Positions are set, not accumulated into a matrix, so nothing drifts.
+ */
 class Shape{
     public:
-        std::vector<float> vertices;
-        std::vector<unsigned int> indices;
         RGB color;
-        unsigned int shader;
-        unsigned int vao, vbo, ebo;
-        unsigned int numElements;
-        unsigned int numComponents;
-        glm::mat4 trans;
-        Shape(unsigned int shader, std::vector<float> vertices, std::vector<unsigned int> indices, RGB color, int numElements);
+        const ShaderProgram* shader;
+        MeshCache* meshes;
+        const Mesh* mesh; //Unit mesh shared with every shape of the same kind
+        int colorLocation, transformLocation;
+        Transform2D transform;
+        Shape(const ShaderProgram& shader, MeshCache& meshes, MeshType type, unsigned int parameter,
+              const std::function<void(std::vector<float>&, std::vector<unsigned int>&)>& build, RGB color, Pos pos, float size);
         ~Shape();
-        void createVAO(unsigned int shader);
-        void createVBO();
-        void createEBO();
-        void render(const glm::mat4& mvMatrix);
+        Shape(const Shape&) = delete;
+        Shape& operator=(const Shape&) = delete;
+        //Camera for every shape drawn with the program until the next call
+        static void setCamera(const ShaderProgram& shader, GLStateCache& state, const glm::mat4& camera);
+        void render();
         void move(float x, float y);
-        void reset();
+        void setPosition(float x, float y);
+        void setScale(float scale);
+        void setRotation(float rotation);
 };
 
 class Square : public Shape{
     public:
-        Square(unsigned int shader, Pos pos, RGB color, float sideLength);
-    private:
-        std::vector<float> calculateVertices(Pos pos, float sideLength);
-        std::vector<unsigned int> calculateIndices();
+        Square(const ShaderProgram& shader, MeshCache& meshes, Pos pos, RGB color, float sideLength);
+        static std::vector<float> calculateVertices(Pos pos, float sideLength);
+        static std::vector<unsigned int> calculateIndices();
 };
 
 class Triangle : public Shape{
     public:
-        Triangle(unsigned int shader, Pos pos, RGB color, float sideLength);
-    private:
-        std::vector<float> calculateVertices(Pos pos, float sideLength);
-        std::vector<unsigned int> calculateIndices();
+        Triangle(const ShaderProgram& shader, MeshCache& meshes, Pos pos, RGB color, float sideLength);
+        static std::vector<float> calculateVertices(Pos pos, float sideLength);
+        static std::vector<unsigned int> calculateIndices();
 };
 
 class Circle : public Shape{
     public:
-        Circle(unsigned int shader, Pos pos, RGB color, float radius, unsigned int numElements);
-    private:
-        std::vector<float> calculateVertices(Pos pos, float radius, unsigned int numElements);
-        std::vector<unsigned int> calculateIndices(unsigned int numElements);
+        unsigned int segments;
+        Circle(const ShaderProgram& shader, MeshCache& meshes, Pos pos, RGB color, float radius, unsigned int numElements);
+        //Switches to the unit circle with numElements segments, a cache lookup when that mesh is alive
+        void setSegments(unsigned int numElements);
+        //One more reference to the unit circle with numElements segments, built on the first request
+        static const Mesh* acquireMesh(const ShaderProgram& shader, MeshCache& meshes, unsigned int numElements);
+        static std::vector<float> calculateVertices(Pos pos, float radius, unsigned int numElements);
+        static std::vector<unsigned int> calculateIndices(unsigned int numElements);
 };
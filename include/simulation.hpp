@@ -0,0 +1,40 @@
+#pragma once
+#include <memory>
+#include "collisions.hpp"
+#include "gravity.hpp"
+#include "integrator.hpp"
+#include "morton.hpp"
+#include "particlesystem.hpp"
+
+#define SIM_STEP 1.0f //Simulation time per step
+#define SIM_STEPS_PER_SECOND 120.0 //Fixed physics rate in steps per wall clock second
+#define SIM_MAX_SUBSTEPS 8 //Steps per frame before we give up catching up (avoids a spiral of death)
+#define SIM_SORT_INTERVAL 32 //Steps between Morton sorts of the bodies
+
+/*
+ * Fixed timestep driver. Wall clock frame time goes into an accumulator which is drained in
+ * whole steps, so results only depend on the step size and not on how fast frames render.
+ */
+class Simulation {
+    public:
+        ParticleSystem particles;
+        GravitySolver* solver;
+        std::unique_ptr<Integrator> integrator;
+        float stepSize;
+        double stepsPerSecond;
+        unsigned int maxSubsteps;
+        double time; //Simulation time
+        unsigned long steps;
+        bool mergeCollisions; //Touching bodies merge after every step
+        unsigned long merges; //Bodies removed by merging so far
+        unsigned int sortInterval; //Steps between Morton sorts, 0 never sorts
+        Simulation(GravitySolver* solver, IntegratorType integratorType = IntegratorType::Leapfrog);
+        void setIntegrator(IntegratorType type);
+        unsigned int advance(double frameSeconds);
+        void step();
+        float getAlpha() const; //Fraction of a step left in the accumulator, for render interpolation
+    private:
+        double accumulator;
+        Collisions collisions;
+        MortonSorter sorter;
+};
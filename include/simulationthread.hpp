@@ -0,0 +1,61 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "cullinggrid.hpp"
+#include "simulation.hpp"
+#include "triplebuffer.hpp"
+#include "utils.hpp"
+
+#define SIM_RATE_WINDOW 1.0 //Seconds over which the published step rate is measured
+
+//What the renderer needs of one simulation state, copied out after every batch of steps
+typedef struct {
+    std::vector<float> x;
+    std::vector<float> y;
+    std::vector<float> prevX; //Positions one step earlier, for interpolation
+    std::vector<float> prevY;
+    std::vector<float> mass;
+    std::vector<unsigned int> ids; //Stable body ids, for per body render state
+    std::vector<RGB> colors;
+    CullingGrid grid; //Over x/y and prevX/prevY, so the renderer only visits bodies in view
+    unsigned long steps;
+    float alpha; //Fraction of the next step already due when published
+    double stepsPerSecond; //Target rate, to advance alpha while the snapshot is shown
+    double measuredStepsPerSecond;
+    std::chrono::steady_clock::time_point published;
+}SimulationSnapshot;
+
+/*
+ * Runs a Simulation on its own thread at its fixed rate and hands snapshots to one reader through a
+ * lock free triple buffer, so a slow frame never stalls the physics and a slow step never blocks a
+ * frame. Only the simulation thread touches the Simulation while it runs; anything else that wants
+ * to change it posts a command, run on the simulation thread between steps.
+ */
+class SimulationThread {
+    public:
+        SimulationThread(Simulation& simulation);
+        ~SimulationThread();
+        void start();
+        void stop();
+        void post(const std::function<void(Simulation&)>& command);
+        //post and wait until it ran, the caller must not be recording profiler zones meanwhile
+        void call(const std::function<void(Simulation&)>& command);
+        //Newest complete snapshot, never blocks. Valid until the next acquire from the same thread
+        const SimulationSnapshot& acquire();
+    private:
+        Simulation& simulation;
+        std::thread thread;
+        std::atomic<bool> running;
+        TripleBuffer<SimulationSnapshot> snapshots;
+        std::mutex commandMutex;
+        std::vector<std::function<void(Simulation&)>> commands;
+        std::vector<std::function<void(Simulation&)>> runningCommands;
+        double measuredStepsPerSecond;
+        void run();
+        void runCommands();
+        void publish();
+};
@@ -0,0 +1,35 @@
+#pragma once
+#include <utility>
+#include <vector>
+#include "particlesystem.hpp"
+
+#define SPATIAL_HASH_MIN_BUCKETS 1024
+#define SPATIAL_HASH_CELL_RADII 4.0f //Cell size in mean body radii
+
+/*
+ * Uniform grid broadphase for overlapping discs. Cells are hashed into a power of two bucket table
+ * at least as large as the body count, so empty space costs nothing and escaping bodies need no
+ * bounds. Every step the table is rebuilt with a counting sort into buffers kept from the last
+ * step, O(N) and no allocations once the body count settles.
+ *
+ * Bodies whose diameter fits in a cell only have to look at the 3x3 cells around their own. The
+ * few larger ones (a sun in a disk of dust) stay out of the table and query the cells their reach
+ * covers instead.
+ */
+class SpatialHash {
+    public:
+        SpatialHash();
+        //Every pair closer than the sum of their radii as (i, j) with i < j, ordered by i
+        void findOverlaps(const ParticleSystem& particles, const std::vector<float>& radius, std::vector<std::pair<int, int>>& pairs);
+    private:
+        float cellSize;
+        unsigned int mask; //Bucket count - 1
+        std::vector<long long> cellX; //Cell of each body
+        std::vector<long long> cellY;
+        std::vector<unsigned int> bucketStart; //Bodies of bucket b are entries[bucketStart[b], bucketStart[b + 1])
+        std::vector<int> entries;
+        std::vector<int> large; //Bodies too big for the 3x3 search, not in the table
+        unsigned int bucket(long long x, long long y) const;
+        long long cell(float position) const;
+        void build(const ParticleSystem& particles, const std::vector<float>& radius);
+};
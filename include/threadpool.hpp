@@ -0,0 +1,39 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+//Called once per block with the block index and the index of the thread running it (0 is the caller)
+typedef std::function<void(unsigned int block, unsigned int thread)> BlockTask;
+
+/*
+ * Persistent worker threads that split a pass into blocks. The calling thread works too, so a pool
+ * of N threads starts N - 1 workers. Blocks are handed out dynamically; a task that needs a
+ * deterministic result should key its scratch data by block, not by thread.
+ */
+class ThreadPool {
+    public:
+        ThreadPool(unsigned int threadCount = 0); //0 uses every hardware thread
+        ~ThreadPool();
+        unsigned int getThreadCount() const;
+        void run(unsigned int blockCount, const BlockTask& task);
+    private:
+        std::vector<std::thread> workers;
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::condition_variable done;
+        const BlockTask* task;
+        unsigned int blockCount;
+        std::atomic<unsigned int> nextBlock;
+        unsigned int busyWorkers;
+        unsigned long generation;
+        bool stopping;
+        void workerLoop(unsigned int thread);
+        void drainBlocks(unsigned int thread);
+};
+
+//pool->run, or every block in order on the calling thread when there is no pool
+void runBlocks(ThreadPool* pool, unsigned int blockCount, const BlockTask& task);
@@ -0,0 +1,81 @@
+#pragma once
+#include <condition_variable>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "simulation.hpp"
+
+#define TRAJECTORY_MAGIC "PLNTTRAJ"
+#define TRAJECTORY_VERSION 1
+#define TRAJECTORY_BUFFERS 8 //Frames the simulation can run ahead of the disk
+#define TRAJECTORY_QUANTUM 1e-3 //Default position step of the delta encoding, in simulation units
+
+enum class TrajectoryEncoding {
+    Raw, //float x, y
+    DeltaVarint //Positions rounded to the quantum, zigzag varint difference to the body's previous frame
+};
+
+/*
+ * Streams body positions to disk without writing from the simulation loop. record() copies the
+ * selected bodies of a due step into a free buffer of a ring allocated up front and returns; a
+ * background thread encodes full buffers and writes them out. Only when the disk falls
+ * TRAJECTORY_BUFFERS frames behind does record() wait, and it counts those stalls.
+ *
+ * File, little endian: magic, uint32 version, uint32 encoding, float64 quantum, uint32 interval,
+ * uint32 body count, then the recorded ids (uint32 each). Then per frame: uint64 step, float64
+ * time, uint32 bodies present, a bitmap of which recorded bodies still exist (merged ones vanish),
+ * and the positions of those present in id list order. Delta encoded positions start from 0 for
+ * every body and stay exact multiples of the quantum, so rounding never accumulates.
+ */
+class TrajectoryRecorder {
+    public:
+        TrajectoryRecorder();
+        ~TrajectoryRecorder();
+        //Records every interval-th step of the given ids, every body present now when ids is empty
+        bool open(const std::string& path, const Simulation& simulation, unsigned int interval, const std::vector<unsigned int>& ids,
+                  TrajectoryEncoding encoding, double quantum = TRAJECTORY_QUANTUM);
+        //Call after every step, only copies when the step is due
+        void record(const Simulation& simulation);
+        //Writes the frames still queued and stops the writer, false if any write failed
+        bool close();
+        unsigned long getFrames() const;
+        //Times record() had to wait for the disk
+        unsigned long getStalls() const;
+        unsigned long long getBytes() const; //Final once closed
+    private:
+        typedef struct {
+            unsigned long step;
+            double time;
+            std::vector<unsigned char> present; //Bit per recorded body
+            std::vector<float> x; //Present bodies only
+            std::vector<float> y;
+        }Frame;
+
+        std::ofstream file;
+        std::thread writer;
+        std::mutex mutex;
+        std::condition_variable changed;
+        Frame frames[TRAJECTORY_BUFFERS];
+        unsigned int head; //Next frame to fill, simulation side
+        unsigned int tail; //Next frame to write, writer side
+        unsigned int queued; //Filled frames not written yet
+        bool closing;
+        bool failed;
+
+        std::vector<unsigned int> ids;
+        unsigned int interval;
+        TrajectoryEncoding encoding;
+        double quantum;
+        unsigned long frameCount;
+        unsigned long stalls;
+        unsigned long long bytes;
+
+        //Writer side
+        std::vector<long long> lastX; //Quantized position of every recorded body in its last frame
+        std::vector<long long> lastY;
+        std::vector<unsigned char> encoded;
+        void run();
+        void encode(const Frame& frame);
+};
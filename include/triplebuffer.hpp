@@ -0,0 +1,48 @@
+#pragma once
+#include <atomic>
+
+#define TRIPLE_BUFFER_INDEX 3 //Slot index bits of the shared middle slot
+#define TRIPLE_BUFFER_FRESH 4 //Middle slot was published and not read yet
+
+/*
+ * Single producer, single consumer hand off of the newest value without locks or waiting. The writer
+ * fills its back slot and publishes it by swapping it with the shared middle slot; the reader swaps
+ * the middle slot with its front slot when a new one was published. Neither side ever touches the
+ * other's slot, so the writer can run ahead and the reader skips values it was too slow for.
+ *
+ * Slots are reused, so values holding vectors stop allocating once they have grown.
+ */
+template<class T>
+class TripleBuffer {
+    public:
+        TripleBuffer() : middle(1){
+            this->back = 0;
+            this->front = 2;
+        }
+
+        //Writer side
+        T& writeSlot(){
+            return this->slots[this->back];
+        }
+        void publish(){
+            //Release: the reader sees everything written to the slot before it acquires it
+            this->back = this->middle.exchange(this->back | TRIPLE_BUFFER_FRESH, std::memory_order_acq_rel) & TRIPLE_BUFFER_INDEX;
+        }
+
+        //Reader side, returns false and keeps the current slot when nothing new was published
+        bool update(){
+            if((this->middle.load(std::memory_order_relaxed) & TRIPLE_BUFFER_FRESH) == 0){
+                return false;
+            }
+            this->front = this->middle.exchange(this->front, std::memory_order_acq_rel) & TRIPLE_BUFFER_INDEX;
+            return true;
+        }
+        const T& readSlot() const{
+            return this->slots[this->front];
+        }
+    private:
+        T slots[3];
+        std::atomic<unsigned int> middle; //Slot index, plus the fresh flag
+        unsigned int back; //Only touched by the writer
+        unsigned int front; //Only touched by the reader
+};
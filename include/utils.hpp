@@ -1,5 +1,7 @@
 #pragma once
 
+#pragma once
+
 typedef struct {
     float r;
     float g;
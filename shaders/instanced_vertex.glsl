@@ -0,0 +1,16 @@
+#version 330 core
+
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aOffset;
+layout (location = 2) in float aRadius;
+layout (location = 3) in vec3 aColor;
+
+uniform mat4 camera;
+
+out vec3 color;
+
+void main()
+{
+   gl_Position = camera * vec4(aPos.xy * aRadius + aOffset, aPos.z, 1.0);
+   color = aColor;
+}
@@ -0,0 +1,15 @@
+#version 330 core
+in vec2 local;
+in vec3 color;
+in float coverage;
+out vec4 FragColor;
+void main()
+{
+    //Signed distance to the edge in radii, fwidth turns it into pixels so the edge is one pixel wide at any zoom
+    float edge = length(local) - 1.0;
+    float alpha = clamp(0.5 - edge / max(fwidth(edge), 1e-6), 0.0, 1.0) * coverage;
+    if(alpha <= 0.0){
+        discard;
+    }
+    FragColor = vec4(color, alpha);
+}
@@ -0,0 +1,25 @@
+#version 330 core
+
+layout (location = 0) in vec2 aCorner;
+layout (location = 1) in vec2 aOffset;
+layout (location = 2) in float aRadius;
+layout (location = 3) in vec3 aColor;
+
+uniform mat4 camera;
+uniform vec2 pixelSize; //World units per pixel along x and y
+
+out vec2 local; //Position relative to the center in radii, the disc is length(local) <= 1
+out vec3 color;
+out float coverage;
+
+void main()
+{
+   //One pixel of margin for the anti-aliased edge, and bodies smaller than a pixel still cover one
+   vec2 halfSize = vec2(aRadius) + pixelSize;
+   float radius = max(aRadius, 1e-12);
+   local = aCorner * halfSize / radius;
+   gl_Position = camera * vec4(aOffset + aCorner * halfSize, 0.0, 1.0);
+   color = aColor;
+   //Sub pixel bodies fade instead of flickering as they cross pixel centers
+   coverage = clamp(2.0 * aRadius / max(pixelSize.x, pixelSize.y), 0.0, 1.0);
+}
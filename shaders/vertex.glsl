@@ -2,10 +2,11 @@
 
 layout (location = 0) in vec3 aPos;
 
-uniform mat4 transform;
+uniform mat4 camera;
+uniform vec4 transform; //x, y, scale * cos(rotation), scale * sin(rotation)
 
 void main()
 {
-   gl_Position = transform * vec4(aPos.x, aPos.y, aPos.z, 1.0);
+   vec2 rotated = vec2(transform.z * aPos.x - transform.w * aPos.y, transform.w * aPos.x + transform.z * aPos.y);
+   gl_Position = camera * vec4(rotated + transform.xy, aPos.z, 1.0);
 }
-
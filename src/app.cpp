@@ -1,10 +1,13 @@
 #include "app.hpp"
+#include <algorithm>
+#include "shape.hpp"
 
-OpenGLApp::OpenGLApp(GLFWwindow* window){
+OpenGLApp::OpenGLApp(GLFWwindow* window) : meshCache(glState){
     this->window = window;
     this->eye = glm::vec3(0.0f, 0.0f, 0.0f);
     this->zoomLevel = 1.0f;
     cameraUpdate = false;
+    std::fill(this->circleLodMeshes, this->circleLodMeshes + CIRCLE_LOD_COUNT, nullptr);
     moveCamera(0.0f, 0.0f);
 }
 
@@ -47,92 +50,129 @@ glm::mat4 OpenGLApp::getCamera(){
     return this->cameraMatrix;
 }
 
-bool OpenGLApp::parseShaders(){
-    /* Vertex Shader */
-    //Read source code to string
-    std::ifstream file("../shaders/vertex.glsl");
+//Reads a shader's source from ../shaders or shaders
+static bool readShaderFile(const std::string& fileName, std::string& source){
+    std::ifstream file("../shaders/" + fileName);
     if(!file.is_open()){
-        file.open("shaders/vertex.glsl");
+        file.open("shaders/" + fileName);
     }
     if(!file.is_open()){
-        std::cerr << "Error: Unable to find vertex shader...\n";
+        std::cerr << "Error: Unable to find shader " << fileName << "...\n";
         return false;
     }
     std::stringstream buffer;
-    std::string bufferString;
-    const char* shaderCode;
     buffer << file.rdbuf();
-    bufferString = buffer.str();
-    shaderCode = bufferString.c_str();
-    file.close();
+    source = buffer.str();
+    return true;
+}
+
+//Compiles one shader stage, returns 0 on failure
+static unsigned int compileShader(GLenum type, const std::string& fileName){
+    std::string source;
+    if(!readShaderFile(fileName, source)){
+        return 0;
+    }
+    const char* shaderCode = source.c_str();
 
     //Compile source code
-    unsigned int vertexShader = glCreateShader(GL_VERTEX_SHADER);
-    glShaderSource(vertexShader, 1, &shaderCode, NULL);
-    glCompileShader(vertexShader);
-    buffer.str("");
+    unsigned int shader = glCreateShader(type);
+    glShaderSource(shader, 1, &shaderCode, NULL);
+    glCompileShader(shader);
 
     // check for shader compile errors
     int success;
     char infoLog[512];
-    glGetShaderiv(vertexShader, GL_COMPILE_STATUS, &success);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &success);
     if (!success)
     {
-        glGetShaderInfoLog(vertexShader, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::VERTEX::COMPILATION_FAILED\n" << infoLog << std::endl;
+        glGetShaderInfoLog(shader, 512, NULL, infoLog);
+        std::cout << "ERROR::SHADER::" << fileName << "::COMPILATION_FAILED\n" << infoLog << std::endl;
+        glDeleteShader(shader);
+        return 0;
     }
+    return shader;
+}
 
-    /* Fragment Shader */
-    //Read source code to string
-    file.open("../shaders/frag.glsl");
-    if(!file.is_open()){
-        file = std::ifstream("shaders/frag.glsl");
+unsigned int OpenGLApp::loadShaderProgram(const std::string& vertexFile, const std::string& fragmentFile){
+    unsigned int vertexShader = compileShader(GL_VERTEX_SHADER, vertexFile);
+    unsigned int fragmentShader = compileShader(GL_FRAGMENT_SHADER, fragmentFile);
+    if(vertexShader == 0 || fragmentShader == 0){
+        glDeleteShader(vertexShader);
+        glDeleteShader(fragmentShader);
+        return 0;
     }
-    
-    if(!file.is_open()){
-        std::cerr << "Error: Unable to find vertex shader...\n";
-        return false;
-    }
-    buffer << file.rdbuf();
-    bufferString = buffer.str();
-    shaderCode = bufferString.c_str();
-    file.close();
 
-    //Compile source code
-    unsigned int fragmentShader = glCreateShader(GL_FRAGMENT_SHADER);
-    glShaderSource(fragmentShader, 1, &shaderCode, NULL);
-    glCompileShader(fragmentShader);
-    buffer.str("");
-
-    // check for shader compile errors
-    glGetShaderiv(fragmentShader, GL_COMPILE_STATUS, &success);
-    if (!success)
-    {
-        glGetShaderInfoLog(fragmentShader, 512, NULL, infoLog);
-        std::cout << "ERROR::SHADER::FRAGMENT::COMPILATION_FAILED\n" << infoLog << std::endl;
-        return false;
-    }
     // link shaders
-    this->shaderProgram = glCreateProgram();
-    glAttachShader(shaderProgram, vertexShader);
-    glAttachShader(shaderProgram, fragmentShader);
-    glLinkProgram(shaderProgram);
+    unsigned int program = glCreateProgram();
+    glAttachShader(program, vertexShader);
+    glAttachShader(program, fragmentShader);
+    glLinkProgram(program);
+    glDeleteShader(vertexShader);
+    glDeleteShader(fragmentShader);
+
     // check for linking errors
-    glGetProgramiv(shaderProgram, GL_LINK_STATUS, &success);
+    int success;
+    char infoLog[512];
+    glGetProgramiv(program, GL_LINK_STATUS, &success);
     if (!success) {
-        glGetProgramInfoLog(shaderProgram, 512, NULL, infoLog);
+        glGetProgramInfoLog(program, 512, NULL, infoLog);
         std::cout << "ERROR::SHADER::PROGRAM::LINKING_FAILED\n" << infoLog << std::endl;
+        glDeleteProgram(program);
+        return 0;
+    }
+    return program;
+}
+
+bool OpenGLApp::parseShaders(){
+    this->shaderProgram = ShaderProgram(loadShaderProgram("vertex.glsl", "frag.glsl"));
+    this->instancedShaderProgram = ShaderProgram(loadShaderProgram("instanced_vertex.glsl", "instanced_frag.glsl"));
+    this->sdfShaderProgram = ShaderProgram(loadShaderProgram("sdf_vertex.glsl", "sdf_frag.glsl"));
+    if(this->shaderProgram.id == 0 || this->instancedShaderProgram.id == 0 || this->sdfShaderProgram.id == 0){
         return false;
     }
-    glDeleteShader(vertexShader);
-    glDeleteShader(fragmentShader);
+
+    //Shapes switch between these as their size on screen changes, none is built or freed after startup
+    for(unsigned int lod = 0; lod < CIRCLE_LOD_COUNT; lod++){
+        if(this->circleLodMeshes[lod] == nullptr){
+            this->circleLodMeshes[lod] = Circle::acquireMesh(this->shaderProgram, this->meshCache, circleLodSegments(lod));
+        }
+    }
     return true;
 }
 
-unsigned int OpenGLApp::getShaderProgram(){
+const ShaderProgram& OpenGLApp::getShaderProgram(){
     return this->shaderProgram;
 }
 
+const ShaderProgram& OpenGLApp::getInstancedShaderProgram(){
+    return this->instancedShaderProgram;
+}
+
+const ShaderProgram& OpenGLApp::getSdfShaderProgram(){
+    return this->sdfShaderProgram;
+}
+
+glm::vec2 OpenGLApp::getPixelSize(){
+    int width, height;
+    glfwGetFramebufferSize(this->window, &width, &height);
+    return glm::vec2((this->orthoInfo.right - this->orthoInfo.left) / std::max(width, 1),
+                     (this->orthoInfo.top - this->orthoInfo.bottom) / std::max(height, 1));
+}
+
+glm::vec4 OpenGLApp::getViewRect(){
+    //The view translates the world by eye before the ortho projection
+    return glm::vec4(this->orthoInfo.left - this->eye.x, this->orthoInfo.bottom - this->eye.y,
+                     this->orthoInfo.right - this->eye.x, this->orthoInfo.top - this->eye.y);
+}
+
+GLStateCache& OpenGLApp::getGLState(){
+    return this->glState;
+}
+
+MeshCache& OpenGLApp::getMeshCache(){
+    return this->meshCache;
+}
+
 float OpenGLApp::getScaleFactor(){
     return this->scaleFactor;
 }
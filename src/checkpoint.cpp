@@ -0,0 +1,411 @@
+#include "checkpoint.hpp"
+#include <algorithm>
+#include <cerrno>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "profiler.hpp"
+
+#define CHECKPOINT_WRITE_BUFFER (1 << 20) //Bytes staged before each write call
+
+#define CHECKPOINT_FLAG_PRIMED 1 //ax/ay hold the accelerations of the saved positions
+#define CHECKPOINT_FLAG_MERGE 2 //Merging of touching bodies was on
+
+namespace {
+
+//Header field offsets
+enum {
+    HEADER_MAGIC = 0,
+    HEADER_VERSION = 8,
+    HEADER_SIZE = 12,
+    HEADER_BODY_COUNT = 16,
+    HEADER_NEXT_ID = 24,
+    HEADER_STEPS = 32,
+    HEADER_TIME = 40,
+    HEADER_STEP_SIZE = 48,
+    HEADER_INTEGRATOR = 52,
+    HEADER_FLAGS = 56,
+    HEADER_FORCE_LAW = 60,
+    HEADER_SOFTENING = 64,
+    HEADER_SECTION_COUNT = 68,
+    HEADER_NAME_BYTES = 72,
+    HEADER_MERGES = 80,
+    HEADER_SECTIONS = 88 //uint64 offset per section
+};
+
+const bool LITTLE_ENDIAN_HOST = __BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__;
+
+//Header fields are encoded byte by byte, so they are little endian on any host
+void putU32(unsigned char* header, size_t offset, uint32_t value){
+    for(int i = 0; i < 4; i++){
+        header[offset + i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+void putU64(unsigned char* header, size_t offset, uint64_t value){
+    for(int i = 0; i < 8; i++){
+        header[offset + i] = (value >> (8 * i)) & 0xFF;
+    }
+}
+
+void putF32(unsigned char* header, size_t offset, float value){
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    putU32(header, offset, bits);
+}
+
+void putF64(unsigned char* header, size_t offset, double value){
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    putU64(header, offset, bits);
+}
+
+uint32_t getU32(const unsigned char* header, size_t offset){
+    uint32_t value = 0;
+    for(int i = 0; i < 4; i++){
+        value |= (uint32_t)header[offset + i] << (8 * i);
+    }
+    return value;
+}
+
+uint64_t getU64(const unsigned char* header, size_t offset){
+    uint64_t value = 0;
+    for(int i = 0; i < 8; i++){
+        value |= (uint64_t)header[offset + i] << (8 * i);
+    }
+    return value;
+}
+
+float getF32(const unsigned char* header, size_t offset){
+    uint32_t bits = getU32(header, offset);
+    float value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+double getF64(const unsigned char* header, size_t offset){
+    uint64_t bits = getU64(header, offset);
+    double value;
+    std::memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+template<class T>
+T swapBytes(T value){
+    unsigned char bytes[sizeof(T)];
+    std::memcpy(bytes, &value, sizeof(T));
+    std::reverse(bytes, bytes + sizeof(T));
+    std::memcpy(&value, bytes, sizeof(T));
+    return value;
+}
+
+//Sections are raw little endian arrays, a plain copy on little endian hosts
+template<class T>
+void copyFromLittleEndian(T* destination, const unsigned char* source, size_t count){
+    std::memcpy(destination, source, count * sizeof(T));
+    if(!LITTLE_ENDIAN_HOST){
+        for(size_t i = 0; i < count; i++){
+            destination[i] = swapBytes(destination[i]);
+        }
+    }
+}
+
+uint64_t alignOffset(uint64_t offset){
+    return (offset + CHECKPOINT_ALIGNMENT - 1) / CHECKPOINT_ALIGNMENT * CHECKPOINT_ALIGNMENT;
+}
+
+uint64_t sectionSize(CheckpointSection section, uint64_t bodyCount, uint64_t nameBytes){
+    switch(section){
+        case CheckpointSection::Colors:
+            return bodyCount * 3 * sizeof(float);
+        case CheckpointSection::NameOffsets:
+            return (bodyCount + 1) * sizeof(uint64_t);
+        case CheckpointSection::NameBytes:
+            return nameBytes;
+        default:
+            return bodyCount * sizeof(float); //Float arrays and the uint32 ids
+    }
+}
+
+//Buffered, little endian writes to a file descriptor
+class CheckpointWriter {
+    public:
+        CheckpointWriter(int fd){
+            this->fd = fd;
+            this->offset = 0;
+            this->failed = false;
+            this->buffer.reserve(CHECKPOINT_WRITE_BUFFER);
+        }
+        void bytes(const void* data, size_t size){
+            const unsigned char* source = static_cast<const unsigned char*>(data);
+            while(size > 0){
+                size_t chunk = std::min(size, CHECKPOINT_WRITE_BUFFER - this->buffer.size());
+                this->buffer.insert(this->buffer.end(), source, source + chunk);
+                source += chunk;
+                size -= chunk;
+                this->offset += chunk;
+                if(this->buffer.size() == CHECKPOINT_WRITE_BUFFER){
+                    flush();
+                }
+            }
+        }
+        template<class T>
+        void values(const T* data, size_t count){
+            if(LITTLE_ENDIAN_HOST){
+                bytes(data, count * sizeof(T));
+                return;
+            }
+            for(size_t i = 0; i < count; i++){
+                T value = swapBytes(data[i]);
+                bytes(&value, sizeof(T));
+            }
+        }
+        void padTo(uint64_t target){
+            static const unsigned char zeros[CHECKPOINT_ALIGNMENT] = {};
+            while(this->offset < target){
+                bytes(zeros, std::min<uint64_t>(target - this->offset, CHECKPOINT_ALIGNMENT));
+            }
+        }
+        bool flush(){
+            size_t done = 0;
+            while(!this->failed && done < this->buffer.size()){
+                ssize_t result = write(this->fd, this->buffer.data() + done, this->buffer.size() - done);
+                if(result < 0 && errno == EINTR){
+                    continue;
+                }
+                if(result <= 0){
+                    this->failed = true;
+                    break;
+                }
+                done += result;
+            }
+            this->buffer.clear();
+            return !this->failed;
+        }
+    private:
+        int fd;
+        uint64_t offset;
+        bool failed;
+        std::vector<unsigned char> buffer;
+};
+
+bool fail(const std::string& path, const std::string& reason){
+    std::cerr << "Checkpoint " << path << ": " << reason << std::endl;
+    return false;
+}
+
+}
+
+bool saveCheckpoint(const Simulation& simulation, const std::string& path){
+    PROFILE_ZONE("saveCheckpoint");
+    const ParticleSystem& particles = simulation.particles;
+    const GravitySolver& solver = *simulation.solver;
+    uint64_t count = particles.size();
+
+    uint64_t nameBytes = 0;
+    for(const Planet& planet: particles.planets){
+        nameBytes += planet.name.size();
+    }
+
+    //Every section at the next aligned offset after the previous one
+    const int sections = (int)CheckpointSection::Count;
+    uint64_t sectionOffset[sections];
+    uint64_t end = CHECKPOINT_HEADER_SIZE;
+    for(int section = 0; section < sections; section++){
+        sectionOffset[section] = alignOffset(end);
+        end = sectionOffset[section] + sectionSize((CheckpointSection)section, count, nameBytes);
+    }
+
+    unsigned char header[CHECKPOINT_HEADER_SIZE] = {};
+    std::memcpy(header + HEADER_MAGIC, CHECKPOINT_MAGIC, 8);
+    putU32(header, HEADER_VERSION, CHECKPOINT_VERSION);
+    putU32(header, HEADER_SIZE, CHECKPOINT_HEADER_SIZE);
+    putU64(header, HEADER_BODY_COUNT, count);
+    putU64(header, HEADER_NEXT_ID, particles.slots.size());
+    putU64(header, HEADER_STEPS, simulation.steps);
+    putF64(header, HEADER_TIME, simulation.time);
+    putF32(header, HEADER_STEP_SIZE, simulation.stepSize);
+    putU32(header, HEADER_INTEGRATOR, (uint32_t)simulation.integrator->getType());
+    putU32(header, HEADER_FLAGS, (simulation.integrator->primed ? CHECKPOINT_FLAG_PRIMED : 0) | (simulation.mergeCollisions ? CHECKPOINT_FLAG_MERGE : 0));
+    putU32(header, HEADER_FORCE_LAW, (uint32_t)solver.getForceLaw());
+    putF32(header, HEADER_SOFTENING, solver.getSoftening());
+    putU32(header, HEADER_SECTION_COUNT, sections);
+    putU64(header, HEADER_NAME_BYTES, nameBytes);
+    putU64(header, HEADER_MERGES, simulation.merges);
+    for(int section = 0; section < sections; section++){
+        putU64(header, HEADER_SECTIONS + 8 * section, sectionOffset[section]);
+    }
+
+    std::string temporary = path + ".tmp";
+    int fd = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if(fd < 0){
+        return fail(temporary, std::strerror(errno));
+    }
+    CheckpointWriter writer(fd);
+    writer.bytes(header, sizeof(header));
+    const std::vector<float>* arrays[] = {&particles.x, &particles.y, &particles.vx, &particles.vy, &particles.ax, &particles.ay,
+                                          &particles.mass, &particles.prevX, &particles.prevY};
+    int section = 0;
+    for(const std::vector<float>* array: arrays){
+        writer.padTo(sectionOffset[section++]);
+        writer.values(array->data(), count);
+    }
+    writer.padTo(sectionOffset[(int)CheckpointSection::Ids]);
+    writer.values(particles.ids.data(), count);
+    writer.padTo(sectionOffset[(int)CheckpointSection::Colors]);
+    for(const Planet& planet: particles.planets){
+        float color[3] = {planet.color.r, planet.color.g, planet.color.b};
+        writer.values(color, 3);
+    }
+    writer.padTo(sectionOffset[(int)CheckpointSection::NameOffsets]);
+    uint64_t nameOffset = 0;
+    for(const Planet& planet: particles.planets){
+        writer.values(&nameOffset, 1);
+        nameOffset += planet.name.size();
+    }
+    writer.values(&nameOffset, 1);
+    writer.padTo(sectionOffset[(int)CheckpointSection::NameBytes]);
+    for(const Planet& planet: particles.planets){
+        writer.bytes(planet.name.data(), planet.name.size());
+    }
+
+    //Data on disk before the rename, and the rename itself on disk before we report success
+    bool written = writer.flush() && fsync(fd) == 0;
+    written = close(fd) == 0 && written;
+    if(!written){
+        unlink(temporary.c_str());
+        return fail(temporary, std::strerror(errno));
+    }
+    if(rename(temporary.c_str(), path.c_str()) != 0){
+        unlink(temporary.c_str());
+        return fail(path, std::strerror(errno));
+    }
+    size_t slash = path.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int directoryFd = open(directory.c_str(), O_RDONLY);
+    if(directoryFd >= 0){
+        fsync(directoryFd);
+        close(directoryFd);
+    }
+    return true;
+}
+
+bool loadCheckpoint(const std::string& path, Simulation& simulation){
+    PROFILE_ZONE("loadCheckpoint");
+    int fd = open(path.c_str(), O_RDONLY);
+    if(fd < 0){
+        return fail(path, std::strerror(errno));
+    }
+    struct stat status;
+    if(fstat(fd, &status) != 0 || status.st_size < CHECKPOINT_HEADER_SIZE){
+        close(fd);
+        return fail(path, "too short for a checkpoint header");
+    }
+    uint64_t fileSize = status.st_size;
+    void* mapping = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if(mapping == MAP_FAILED){
+        return fail(path, std::strerror(errno));
+    }
+    //Every section is read front to back exactly once
+    madvise(mapping, fileSize, MADV_SEQUENTIAL);
+    const unsigned char* file = static_cast<const unsigned char*>(mapping);
+
+    //Validate everything before touching the simulation
+    std::string error;
+    uint64_t count = getU64(file, HEADER_BODY_COUNT);
+    uint64_t nextId = getU64(file, HEADER_NEXT_ID);
+    uint64_t nameBytes = getU64(file, HEADER_NAME_BYTES);
+    uint32_t integrator = getU32(file, HEADER_INTEGRATOR);
+    uint32_t law = getU32(file, HEADER_FORCE_LAW);
+    const int sections = (int)CheckpointSection::Count;
+    uint64_t sectionOffset[sections];
+    if(std::memcmp(file + HEADER_MAGIC, CHECKPOINT_MAGIC, 8) != 0){
+        error = "not a checkpoint";
+    }else if(getU32(file, HEADER_VERSION) != CHECKPOINT_VERSION){
+        error = "version " + std::to_string(getU32(file, HEADER_VERSION)) + ", this build reads " + std::to_string(CHECKPOINT_VERSION);
+    }else if(getU32(file, HEADER_SIZE) != CHECKPOINT_HEADER_SIZE || getU32(file, HEADER_SECTION_COUNT) != (uint32_t)sections){
+        error = "unexpected header layout";
+    }else if(count > fileSize / sizeof(float) || nameBytes > fileSize || count > nextId || nextId > 0xFFFFFFFFull){
+        error = "body count does not fit the file";
+    }else if(integrator > (uint32_t)IntegratorType::Yoshida4 || law > (uint32_t)ForceLaw::Plummer){
+        error = "unknown integrator or force law";
+    }
+    for(int section = 0; section < sections && error.empty(); section++){
+        sectionOffset[section] = getU64(file, HEADER_SECTIONS + 8 * section);
+        uint64_t size = sectionSize((CheckpointSection)section, count, nameBytes);
+        if(sectionOffset[section] < CHECKPOINT_HEADER_SIZE || sectionOffset[section] > fileSize || size > fileSize - sectionOffset[section]){
+            error = "section " + std::to_string(section) + " runs past the end of the file";
+        }
+    }
+    std::vector<uint64_t> nameOffsets;
+    if(error.empty()){
+        nameOffsets.resize(count + 1);
+        copyFromLittleEndian(nameOffsets.data(), file + sectionOffset[(int)CheckpointSection::NameOffsets], count + 1);
+        for(uint64_t i = 0; i < count && error.empty(); i++){
+            if(nameOffsets[i] > nameOffsets[i + 1]){
+                error = "corrupt name table";
+            }
+        }
+        if(nameOffsets[0] != 0 || nameOffsets[count] != nameBytes){
+            error = "corrupt name table";
+        }
+    }
+    std::vector<unsigned int> ids;
+    std::vector<int> slots;
+    if(error.empty()){
+        ids.resize(count);
+        copyFromLittleEndian(ids.data(), file + sectionOffset[(int)CheckpointSection::Ids], count);
+        slots.assign(nextId, -1);
+        for(uint64_t i = 0; i < count && error.empty(); i++){
+            if(ids[i] >= nextId || slots[ids[i]] != -1){
+                error = "corrupt body ids";
+            }else{
+                slots[ids[i]] = i;
+            }
+        }
+    }
+    if(!error.empty()){
+        munmap(mapping, fileSize);
+        return fail(path, error);
+    }
+
+    ParticleSystem& particles = simulation.particles;
+    std::vector<float>* arrays[] = {&particles.x, &particles.y, &particles.vx, &particles.vy, &particles.ax, &particles.ay,
+                                    &particles.mass, &particles.prevX, &particles.prevY};
+    int section = 0;
+    for(std::vector<float>* array: arrays){
+        array->resize(count);
+        copyFromLittleEndian(array->data(), file + sectionOffset[section++], count);
+    }
+    particles.ids.swap(ids);
+    particles.slots.swap(slots);
+
+    std::vector<float> colors(count * 3);
+    copyFromLittleEndian(colors.data(), file + sectionOffset[(int)CheckpointSection::Colors], count * 3);
+    const char* names = reinterpret_cast<const char*>(file + sectionOffset[(int)CheckpointSection::NameBytes]);
+    particles.planets.clear();
+    particles.planets.reserve(count);
+    for(uint64_t i = 0; i < count; i++){
+        RGB color = {colors[3 * i], colors[3 * i + 1], colors[3 * i + 2]};
+        particles.planets.push_back(Planet(std::string(names + nameOffsets[i], nameOffsets[i + 1] - nameOffsets[i]), color));
+    }
+
+    uint32_t flags = getU32(file, HEADER_FLAGS);
+    simulation.steps = getU64(file, HEADER_STEPS);
+    simulation.time = getF64(file, HEADER_TIME);
+    simulation.stepSize = getF32(file, HEADER_STEP_SIZE);
+    simulation.merges = getU64(file, HEADER_MERGES);
+    simulation.mergeCollisions = (flags & CHECKPOINT_FLAG_MERGE) != 0;
+    simulation.solver->setForceLaw((ForceLaw)law, getF32(file, HEADER_SOFTENING));
+    simulation.setIntegrator((IntegratorType)integrator);
+    //The saved accelerations are those of the saved positions, the next step kicks with them as if never stopped
+    simulation.integrator->primed = (flags & CHECKPOINT_FLAG_PRIMED) != 0;
+    munmap(mapping, fileSize);
+    return true;
+}
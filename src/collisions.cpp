@@ -0,0 +1,50 @@
+#include "collisions.hpp"
+#include <algorithm>
+#include <functional>
+#include "profiler.hpp"
+
+size_t Collisions::merge(ParticleSystem& particles){
+    PROFILE_ZONE("Collisions::merge");
+    size_t count = particles.size();
+    this->radius.resize(count);
+    for(size_t i = 0; i < count; i++){
+        this->radius[i] = bodyRadius(particles.mass[i]);
+    }
+    this->grid.findOverlaps(particles, this->radius, this->pairs);
+    if(this->pairs.empty()){
+        return 0;
+    }
+
+    this->merged.assign(count, 0);
+    this->removed.clear();
+    for(const std::pair<int, int>& pair: this->pairs){
+        int keep = pair.first, absorb = pair.second;
+        if(this->merged[keep] || this->merged[absorb]){
+            continue;
+        }
+        if(particles.mass[absorb] > particles.mass[keep]){
+            std::swap(keep, absorb);
+        }
+        this->merged[keep] = 1;
+        this->merged[absorb] = 1;
+
+        //Conserve mass, momentum and the center of mass
+        float m1 = particles.mass[keep], m2 = particles.mass[absorb];
+        float total = m1 + m2;
+        particles.x[keep] = (m1 * particles.x[keep] + m2 * particles.x[absorb]) / total;
+        particles.y[keep] = (m1 * particles.y[keep] + m2 * particles.y[absorb]) / total;
+        particles.prevX[keep] = (m1 * particles.prevX[keep] + m2 * particles.prevX[absorb]) / total;
+        particles.prevY[keep] = (m1 * particles.prevY[keep] + m2 * particles.prevY[absorb]) / total;
+        particles.vx[keep] = (m1 * particles.vx[keep] + m2 * particles.vx[absorb]) / total;
+        particles.vy[keep] = (m1 * particles.vy[keep] + m2 * particles.vy[absorb]) / total;
+        particles.mass[keep] = total;
+        this->removed.push_back(absorb);
+    }
+
+    //Highest index first, so swap and pop never moves a body that is still to be removed
+    std::sort(this->removed.begin(), this->removed.end(), std::greater<int>());
+    for(int i: this->removed){
+        particles.removeBody(i);
+    }
+    return this->removed.size();
+}
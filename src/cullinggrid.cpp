@@ -0,0 +1,149 @@
+#include "cullinggrid.hpp"
+#include <algorithm>
+#include <cmath>
+#include "planet.hpp"
+#include "profiler.hpp"
+
+static bool overlaps(const CullingRect& a, const CullingRect& b){
+    return a.minX <= b.maxX && b.minX <= a.maxX && a.minY <= b.maxY && b.minY <= a.maxY;
+}
+
+static bool contains(const CullingRect& outer, const CullingRect& inner){
+    return outer.minX <= inner.minX && inner.maxX <= outer.maxX && outer.minY <= inner.minY && inner.maxY <= outer.maxY;
+}
+
+CullingGrid::CullingGrid(){
+    this->originX = 0.0f;
+    this->originY = 0.0f;
+    this->cellSize = 1.0f;
+    this->columns = 0;
+    this->rows = 0;
+}
+
+void CullingGrid::build(const std::vector<float>& x, const std::vector<float>& y, const std::vector<float>& prevX,
+                        const std::vector<float>& prevY, const std::vector<float>& mass){
+    PROFILE_ZONE("CullingGrid::build");
+    size_t count = x.size();
+    this->large.clear();
+    this->cellStart.assign(1, 0);
+    this->columns = this->rows = 0;
+    if(count == 0){
+        return;
+    }
+
+    this->bodyBounds.resize(count);
+    for(size_t i = 0; i < count; i++){
+        float radius = bodyRadius(mass[i]);
+        this->bodyBounds[i] = {std::fmin(x[i], prevX[i]) - radius, std::fmin(y[i], prevY[i]) - radius,
+                               std::fmax(x[i], prevX[i]) + radius, std::fmax(y[i], prevY[i]) + radius};
+    }
+
+    //The grid spans all but the outermost CULLING_GRID_OUTLIERS of the bodies, so one escaping body does not
+    //stretch every cell. Estimated from an even sample, bodies the estimate leaves out are tested on their own
+    size_t stride = std::max<size_t>(count / CULLING_GRID_SAMPLES, 1);
+    auto quantiles = [&](const std::vector<float>& values, float& low, float& high){
+        this->scratch.clear();
+        for(size_t i = 0; i < count; i += stride){
+            this->scratch.push_back(values[i]);
+        }
+        size_t outliers = this->scratch.size() * CULLING_GRID_OUTLIERS;
+        std::nth_element(this->scratch.begin(), this->scratch.begin() + outliers, this->scratch.end());
+        low = this->scratch[outliers];
+        std::nth_element(this->scratch.begin(), this->scratch.end() - 1 - outliers, this->scratch.end());
+        high = this->scratch[this->scratch.size() - 1 - outliers];
+    };
+    float minX, maxX, minY, maxY;
+    quantiles(x, minX, maxX);
+    quantiles(y, minY, maxY);
+
+    //Square cells holding CULLING_GRID_BODIES_PER_CELL bodies if they were spread evenly
+    double width = std::fmax(maxX - minX, 1e-6);
+    double height = std::fmax(maxY - minY, 1e-6);
+    double cells = std::fmax((double)count / CULLING_GRID_BODIES_PER_CELL, 1.0);
+    this->cellSize = std::sqrt(width * height / cells);
+    this->cellSize = std::fmax(this->cellSize, std::fmax(width, height) / cells);
+    this->columns = std::min((int)(width / this->cellSize) + 1, (int)cells + 1);
+    this->rows = std::min((int)(height / this->cellSize) + 1, (int)cells + 1);
+    this->originX = minX;
+    this->originY = minY;
+
+    //Counting sort by cell, with each cell's bounds as the union of its bodies'
+    int cellCount = this->columns * this->rows;
+    this->cellOf.resize(count);
+    this->cellStart.assign(cellCount + 1, 0);
+    this->cellBounds.assign(cellCount, {INFINITY, INFINITY, -INFINITY, -INFINITY});
+    for(size_t i = 0; i < count; i++){
+        const CullingRect& bounds = this->bodyBounds[i];
+        float reach = std::fmax(std::fmax(x[i] - bounds.minX, bounds.maxX - x[i]), std::fmax(y[i] - bounds.minY, bounds.maxY - y[i]));
+        if(reach > this->cellSize || !(x[i] >= minX && x[i] <= maxX && y[i] >= minY && y[i] <= maxY)){
+            this->cellOf[i] = -1;
+            this->large.push_back(i);
+            continue;
+        }
+        int column = std::min((int)((x[i] - this->originX) / this->cellSize), this->columns - 1);
+        int row = std::min((int)((y[i] - this->originY) / this->cellSize), this->rows - 1);
+        int cell = row * this->columns + column;
+        this->cellOf[i] = cell;
+        this->cellStart[cell + 1]++;
+        CullingRect& cellBounds = this->cellBounds[cell];
+        cellBounds.minX = std::fmin(cellBounds.minX, bounds.minX);
+        cellBounds.minY = std::fmin(cellBounds.minY, bounds.minY);
+        cellBounds.maxX = std::fmax(cellBounds.maxX, bounds.maxX);
+        cellBounds.maxY = std::fmax(cellBounds.maxY, bounds.maxY);
+    }
+    for(int cell = 0; cell < cellCount; cell++){
+        this->cellStart[cell + 1] += this->cellStart[cell];
+    }
+    this->order.resize(this->cellStart[cellCount]);
+    for(size_t i = 0; i < count; i++){
+        if(this->cellOf[i] >= 0){
+            //cellStart[c] doubles as the insert cursor and ends up at the start of cell c + 1
+            this->order[this->cellStart[this->cellOf[i]]++] = i;
+        }
+    }
+    for(int cell = cellCount; cell > 0; cell--){
+        this->cellStart[cell] = this->cellStart[cell - 1];
+    }
+    this->cellStart[0] = 0;
+}
+
+void CullingGrid::query(const CullingRect& view, std::vector<unsigned int>& visible) const{
+    PROFILE_ZONE("CullingGrid::query");
+    visible.clear();
+    for(unsigned int i: this->large){
+        if(overlaps(view, this->bodyBounds[i])){
+            visible.push_back(i);
+        }
+    }
+    if(this->columns == 0){
+        return;
+    }
+
+    //A small body's bounds reach at most a cell past its own, so only cells within one cell of the view can touch it
+    double firstColumn = std::floor((view.minX - this->originX) / this->cellSize) - 1;
+    double lastColumn = std::floor((view.maxX - this->originX) / this->cellSize) + 1;
+    double firstRow = std::floor((view.minY - this->originY) / this->cellSize) - 1;
+    double lastRow = std::floor((view.maxY - this->originY) / this->cellSize) + 1;
+    int column0 = std::fmin(std::fmax(firstColumn, 0.0), this->columns);
+    int column1 = std::fmax(std::fmin(lastColumn, this->columns - 1.0), -1.0);
+    int row0 = std::fmin(std::fmax(firstRow, 0.0), this->rows);
+    int row1 = std::fmax(std::fmin(lastRow, this->rows - 1.0), -1.0);
+    for(int row = row0; row <= row1; row++){
+        for(int column = column0; column <= column1; column++){
+            int cell = row * this->columns + column;
+            unsigned int begin = this->cellStart[cell], end = this->cellStart[cell + 1];
+            if(begin == end || !overlaps(view, this->cellBounds[cell])){
+                continue;
+            }
+            if(contains(view, this->cellBounds[cell])){
+                visible.insert(visible.end(), this->order.begin() + begin, this->order.begin() + end);
+                continue;
+            }
+            for(unsigned int e = begin; e < end; e++){
+                if(overlaps(view, this->bodyBounds[this->order[e]])){
+                    visible.push_back(this->order[e]);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,108 @@
+#include "fft.hpp"
+#include <algorithm>
+#include <cmath>
+
+#define FFT_BLOCK 16 //Rows or columns per pool block
+
+FFT2D::FFT2D(unsigned int size){
+    this->size = size;
+    this->levels = 0;
+    while((1u << this->levels) < size){
+        this->levels++;
+    }
+
+    //Twiddles in double so large sizes keep full float precision
+    this->twiddles.resize(size / 2);
+    for(unsigned int k = 0; k < size / 2; k++){
+        double angle = -2.0 * M_PI * k / size;
+        this->twiddles[k] = Complex((float)std::cos(angle), (float)std::sin(angle));
+    }
+    this->bitReverse.resize(size);
+    for(unsigned int i = 0; i < size; i++){
+        unsigned int reversed = 0;
+        for(unsigned int bit = 0; bit < this->levels; bit++){
+            reversed |= ((i >> bit) & 1) << (this->levels - 1 - bit);
+        }
+        this->bitReverse[i] = reversed;
+    }
+}
+
+unsigned int FFT2D::getSize() const{
+    return this->size;
+}
+
+//Iterative Cooley-Tukey, the inverse uses conjugate twiddles
+void FFT2D::transform(Complex* values, bool inverse) const{
+    for(unsigned int i = 0; i < this->size; i++){
+        unsigned int j = this->bitReverse[i];
+        if(i < j){
+            std::swap(values[i], values[j]);
+        }
+    }
+    for(unsigned int length = 2; length <= this->size; length *= 2){
+        unsigned int half = length / 2;
+        unsigned int twiddleStep = this->size / length;
+        for(unsigned int start = 0; start < this->size; start += length){
+            for(unsigned int k = 0; k < half; k++){
+                Complex twiddle = this->twiddles[k * twiddleStep];
+                if(inverse){
+                    twiddle = std::conj(twiddle);
+                }
+                Complex even = values[start + k];
+                Complex odd = multiply(values[start + k + half], twiddle);
+                values[start + k] = even + odd;
+                values[start + k + half] = even - odd;
+            }
+        }
+    }
+}
+
+void FFT2D::transformRows(std::vector<Complex>& data, unsigned int rows, bool inverse, ThreadPool* pool){
+    unsigned int blocks = (rows + FFT_BLOCK - 1) / FFT_BLOCK;
+    auto rowBlock = [&](unsigned int block, unsigned int){
+        unsigned int end = std::min(rows, (block + 1) * FFT_BLOCK);
+        for(unsigned int row = block * FFT_BLOCK; row < end; row++){
+            transform(&data[(size_t)row * this->size], inverse);
+        }
+    };
+    runBlocks(pool, blocks, rowBlock);
+}
+
+void FFT2D::transformColumns(std::vector<Complex>& data, bool inverse, ThreadPool* pool){
+    unsigned int threads = pool != nullptr ? pool->getThreadCount() : 1;
+    this->columns.resize(threads);
+    unsigned int blocks = (this->size + FFT_BLOCK - 1) / FFT_BLOCK;
+    auto columnBlock = [&](unsigned int block, unsigned int thread){
+        //The block's columns are gathered row by row so every row is read as one contiguous run
+        std::vector<Complex>& columns = this->columns[thread];
+        columns.resize((size_t)FFT_BLOCK * this->size);
+        unsigned int first = block * FFT_BLOCK;
+        unsigned int width = std::min(this->size, first + FFT_BLOCK) - first;
+        for(unsigned int y = 0; y < this->size; y++){
+            const Complex* row = &data[(size_t)y * this->size + first];
+            for(unsigned int x = 0; x < width; x++){
+                columns[(size_t)x * this->size + y] = row[x];
+            }
+        }
+        for(unsigned int x = 0; x < width; x++){
+            transform(&columns[(size_t)x * this->size], inverse);
+        }
+        for(unsigned int y = 0; y < this->size; y++){
+            Complex* row = &data[(size_t)y * this->size + first];
+            for(unsigned int x = 0; x < width; x++){
+                row[x] = columns[(size_t)x * this->size + y];
+            }
+        }
+    };
+    runBlocks(pool, blocks, columnBlock);
+}
+
+void FFT2D::forward(std::vector<Complex>& data, unsigned int usedRows, ThreadPool* pool){
+    transformRows(data, std::min(usedRows, this->size), false, pool);
+    transformColumns(data, false, pool);
+}
+
+void FFT2D::inverse(std::vector<Complex>& data, unsigned int neededRows, ThreadPool* pool){
+    transformColumns(data, true, pool);
+    transformRows(data, std::min(neededRows, this->size), true, pool);
+}
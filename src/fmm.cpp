@@ -0,0 +1,418 @@
+#include "fmm.hpp"
+#include <algorithm>
+#include <cmath>
+#include "planet.hpp"
+#include "profiler.hpp"
+
+#define FMM_BLOCK 64 //Nodes per pool block
+
+//Series and binomial coefficients, computed at compile time for each order
+template<int P>
+struct FmmTables {
+    double series[2 * P]; //c_n = binom(2n, n) / 4^n, the coefficients of (1 - w)^-1/2
+    double binomial[2 * P][2 * P];
+    constexpr FmmTables() : series(), binomial() {
+        for(int n = 0; n < 2 * P; n++){
+            series[n] = n == 0 ? 1.0 : series[n - 1] * (2 * n - 1) / (2 * n);
+            for(int k = 0; k <= n; k++){
+                binomial[n][k] = (k == 0 || k == n) ? 1.0 : binomial[n - 1][k - 1] + binomial[n - 1][k];
+            }
+        }
+    }
+};
+
+template<int P>
+constexpr FmmTables<P> fmmTables = FmmTables<P>();
+
+typedef std::complex<double> Coefficient;
+
+//Multipole about the parent from one about a child at offset d from it
+template<int P>
+static void multipoleToMultipole(const Coefficient* child, Coefficient d, Coefficient* parent){
+    const FmmTables<P>& tables = fmmTables<P>;
+    Coefficient powers[P], conjugatePowers[P];
+    powers[0] = 1.0;
+    for(int n = 1; n < P; n++){
+        powers[n] = powers[n - 1] * d;
+    }
+    for(int n = 0; n < P; n++){
+        conjugatePowers[n] = std::conj(powers[n]);
+    }
+
+    //(a + d)^k (conj(a) + conj(d))^l, one binomial series per direction
+    Coefficient shifted[P * P];
+    for(int k = 0; k < P; k++){
+        for(int l = 0; l < P; l++){
+            Coefficient sum = 0.0;
+            for(int i = 0; i <= k; i++){
+                sum += tables.binomial[k][i] * powers[k - i] * child[i * P + l];
+            }
+            shifted[k * P + l] = sum;
+        }
+    }
+    for(int k = 0; k < P; k++){
+        for(int l = 0; l < P; l++){
+            Coefficient sum = 0.0;
+            for(int j = 0; j <= l; j++){
+                sum += tables.binomial[l][j] * conjugatePowers[l - j] * shifted[k * P + j];
+            }
+            parent[k * P + l] += sum;
+        }
+    }
+}
+
+//Local expansion at a target cell from the multipole of a source cell at offset -z0 from it
+template<int P>
+static void multipoleToLocal(const Coefficient* multipole, Coefficient z0, Coefficient* local){
+    const FmmTables<P>& tables = fmmTables<P>;
+    Coefficient inverse = 1.0 / z0;
+    Coefficient series[2 * P - 1];
+    Coefficient power = 1.0;
+    for(int n = 0; n < 2 * P - 1; n++){
+        series[n] = tables.series[n] * power;
+        power *= inverse;
+    }
+    //transfer[k * P + j] = binom(k + j, k) (-1)^j c_(k+j) / z0^(k+j), source power k to target power j
+    Coefficient transfer[P * P];
+    for(int k = 0; k < P; k++){
+        for(int j = 0; j < P; j++){
+            transfer[k * P + j] = ((j & 1) ? -tables.binomial[k + j][k] : tables.binomial[k + j][k]) * series[k + j];
+        }
+    }
+
+    Coefficient half[P * P];
+    for(int k = 0; k < P; k++){
+        for(int q = 0; q < P; q++){
+            Coefficient sum = 0.0;
+            for(int l = 0; l < P; l++){
+                sum += multipole[k * P + l] * std::conj(transfer[l * P + q]);
+            }
+            half[k * P + q] = sum;
+        }
+    }
+    //The potential is real so L_qj = conj(L_jq), only j <= q is summed
+    double scale = 1.0 / std::abs(z0);
+    for(int j = 0; j < P; j++){
+        for(int q = j; q < P; q++){
+            Coefficient sum = 0.0;
+            for(int k = 0; k < P; k++){
+                sum += transfer[k * P + j] * half[k * P + q];
+            }
+            sum *= scale;
+            local[j * P + q] += sum;
+            if(q != j){
+                local[q * P + j] += std::conj(sum);
+            }
+        }
+    }
+}
+
+//Local expansion about a child at offset d from the parent's center
+template<int P>
+static void localToLocal(const Coefficient* parent, Coefficient d, Coefficient* child){
+    const FmmTables<P>& tables = fmmTables<P>;
+    Coefficient powers[P], conjugatePowers[P];
+    powers[0] = 1.0;
+    for(int n = 1; n < P; n++){
+        powers[n] = powers[n - 1] * d;
+    }
+    for(int n = 0; n < P; n++){
+        conjugatePowers[n] = std::conj(powers[n]);
+    }
+
+    Coefficient shifted[P * P];
+    for(int j = 0; j < P; j++){
+        for(int q = 0; q < P; q++){
+            Coefficient sum = 0.0;
+            for(int i = j; i < P; i++){
+                sum += tables.binomial[i][j] * powers[i - j] * parent[i * P + q];
+            }
+            shifted[j * P + q] = sum;
+        }
+    }
+    for(int j = 0; j < P; j++){
+        for(int q = 0; q < P; q++){
+            Coefficient sum = 0.0;
+            for(int i = q; i < P; i++){
+                sum += tables.binomial[i][q] * conjugatePowers[i - q] * shifted[j * P + i];
+            }
+            child[j * P + q] += sum;
+        }
+    }
+}
+
+//Runs blocks of nodes from a list on the pool
+static void runNodeBlocks(ThreadPool* pool, const std::vector<int>& nodes, const std::function<void(int node)>& task){
+    unsigned int blocks = (nodes.size() + FMM_BLOCK - 1) / FMM_BLOCK;
+    runBlocks(pool, blocks, [&](unsigned int block, unsigned int){
+        size_t end = std::min(nodes.size(), (size_t)(block + 1) * FMM_BLOCK);
+        for(size_t i = (size_t)block * FMM_BLOCK; i < end; i++){
+            task(nodes[i]);
+        }
+    });
+}
+
+//Interaction pairs grouped by target, in the order they were found
+static void groupByTarget(const std::vector<std::pair<int, int>>& pairs, size_t nodeCount, std::vector<int>& start, std::vector<int>& sources){
+    start.assign(nodeCount + 1, 0);
+    for(const std::pair<int, int>& pair: pairs){
+        start[pair.first + 1]++;
+    }
+    for(size_t node = 0; node < nodeCount; node++){
+        start[node + 1] += start[node];
+    }
+    sources.resize(pairs.size());
+    std::vector<int> next(start.begin(), start.end() - 1);
+    for(const std::pair<int, int>& pair: pairs){
+        sources[next[pair.first]++] = pair.second;
+    }
+}
+
+template<int P>
+FastMultipole<P>::FastMultipole(unsigned int leafSize) : tree(leafSize){
+    this->minSeparation = MIN_DISTANCE_THRESHOLD;
+}
+
+template<int P>
+void FastMultipole<P>::buildLevels(){
+    size_t nodeCount = this->tree.nodes.size();
+    this->parent.assign(nodeCount, -1);
+    std::vector<int> depth(nodeCount, 0);
+    this->levels.clear();
+    this->leaves.clear();
+
+    //Children always come after their parent in the node array
+    for(size_t node = 0; node < nodeCount; node++){
+        const QuadNode& quad = this->tree.nodes[node];
+        if(this->parent[node] >= 0){
+            depth[node] = depth[this->parent[node]] + 1;
+        }
+        if(quad.count == 0){
+            continue;
+        }
+        if((int)this->levels.size() <= depth[node]){
+            this->levels.resize(depth[node] + 1);
+        }
+        this->levels[depth[node]].push_back(node);
+        if(quad.firstChild < 0){
+            this->leaves.push_back(node);
+            continue;
+        }
+        for(int q = 0; q < 4; q++){
+            this->parent[quad.firstChild + q] = node;
+        }
+    }
+}
+
+template<int P>
+void FastMultipole<P>::upward(const ParticleSystem& particles, ThreadPool* pool){
+    PROFILE_ZONE("FastMultipole::upward");
+    this->multipoles.resize(this->tree.nodes.size());
+    this->radius.resize(this->tree.nodes.size());
+
+    //Deepest level first, every node pulls from its children so a level runs in parallel
+    for(int level = (int)this->levels.size() - 1; level >= 0; level--){
+        runNodeBlocks(pool, this->levels[level], [&](int node){
+            const QuadNode& quad = this->tree.nodes[node];
+            Coefficient* multipole = this->multipoles[node].terms;
+            std::fill(multipole, multipole + P * P, Coefficient(0.0));
+            double radius = 0.0;
+
+            if(quad.firstChild < 0){
+                //M_kl = sum m a^k conj(a)^l, only k <= l is summed since M_lk = conj(M_kl)
+                for(int i = quad.begin; i < quad.begin + quad.count; i++){
+                    int body = this->tree.order[i];
+                    Coefficient a((double)particles.x[body] - quad.comX, (double)particles.y[body] - quad.comY);
+                    radius = std::max(radius, std::abs(a));
+                    Coefficient powers[P];
+                    powers[0] = 1.0;
+                    for(int n = 1; n < P; n++){
+                        powers[n] = powers[n - 1] * a;
+                    }
+                    double mass = particles.mass[body];
+                    for(int k = 0; k < P; k++){
+                        for(int l = k; l < P; l++){
+                            multipole[k * P + l] += mass * powers[k] * std::conj(powers[l]);
+                        }
+                    }
+                }
+                for(int k = 0; k < P; k++){
+                    for(int l = 0; l < k; l++){
+                        multipole[k * P + l] = std::conj(multipole[l * P + k]);
+                    }
+                }
+            }else{
+                for(int q = 0; q < 4; q++){
+                    int child = quad.firstChild + q;
+                    const QuadNode& childQuad = this->tree.nodes[child];
+                    if(childQuad.count == 0){
+                        continue;
+                    }
+                    Coefficient d((double)childQuad.comX - quad.comX, (double)childQuad.comY - quad.comY);
+                    multipoleToMultipole<P>(this->multipoles[child].terms, d, multipole);
+                    radius = std::max(radius, std::abs(d) + this->radius[child]);
+                }
+            }
+            this->radius[node] = radius;
+        });
+    }
+}
+
+template<int P>
+void FastMultipole<P>::interact(int a, int b, float theta){
+    const QuadNode& nodeA = this->tree.nodes[a];
+    const QuadNode& nodeB = this->tree.nodes[b];
+    if(nodeA.count == 0 || nodeB.count == 0){
+        return;
+    }
+    bool leafA = nodeA.firstChild < 0;
+    bool leafB = nodeB.firstChild < 0;
+
+    if(a == b){
+        if(leafA){
+            this->p2pPairs.push_back(std::make_pair(a, a));
+            return;
+        }
+        for(int q1 = 0; q1 < 4; q1++){
+            for(int q2 = q1; q2 < 4; q2++){
+                interact(nodeA.firstChild + q1, nodeA.firstChild + q2, theta);
+            }
+        }
+        return;
+    }
+
+    //Expansions converge when the cells are far apart relative to their size, and they are of the
+    //plain 1/r^2 law so no pair of their bodies may be close enough to feel the cutoff or softening
+    double dx = (double)nodeA.comX - nodeB.comX;
+    double dy = (double)nodeA.comY - nodeB.comY;
+    double distance = std::sqrt(dx * dx + dy * dy);
+    double radii = this->radius[a] + this->radius[b];
+    if(radii < theta * distance && distance - radii >= this->minSeparation){
+        this->m2lPairs.push_back(std::make_pair(a, b));
+        this->m2lPairs.push_back(std::make_pair(b, a));
+        return;
+    }
+    if(leafA && leafB){
+        this->p2pPairs.push_back(std::make_pair(a, b));
+        this->p2pPairs.push_back(std::make_pair(b, a));
+        return;
+    }
+
+    //Open the larger cell
+    bool splitA = leafB || (!leafA && this->radius[a] >= this->radius[b]);
+    int split = splitA ? a : b;
+    int other = splitA ? b : a;
+    int firstChild = this->tree.nodes[split].firstChild;
+    for(int q = 0; q < 4; q++){
+        interact(firstChild + q, other, theta);
+    }
+}
+
+template<int P>
+void FastMultipole<P>::downward(ParticleSystem& particles, ThreadPool* pool){
+    PROFILE_ZONE("FastMultipole::downward");
+    this->locals.resize(this->tree.nodes.size());
+
+    //Top level first, every node pulls its parent's expansion and adds its own far field
+    for(size_t level = 0; level < this->levels.size(); level++){
+        runNodeBlocks(pool, this->levels[level], [&](int node){
+            const QuadNode& quad = this->tree.nodes[node];
+            Coefficient* local = this->locals[node].terms;
+            std::fill(local, local + P * P, Coefficient(0.0));
+            int parent = this->parent[node];
+            if(parent >= 0){
+                const QuadNode& parentQuad = this->tree.nodes[parent];
+                Coefficient d((double)quad.comX - parentQuad.comX, (double)quad.comY - parentQuad.comY);
+                localToLocal<P>(this->locals[parent].terms, d, local);
+            }
+            for(int i = this->m2lStart[node]; i < this->m2lStart[node + 1]; i++){
+                int source = this->m2lSources[i];
+                const QuadNode& sourceQuad = this->tree.nodes[source];
+                Coefficient z0((double)quad.comX - sourceQuad.comX, (double)quad.comY - sourceQuad.comY);
+                multipoleToLocal<P>(this->multipoles[source].terms, z0, local);
+            }
+        });
+    }
+
+    //Bodies: far field from the leaf's local expansion, near field summed directly
+    const ForceParams& params = this->params;
+    runNodeBlocks(pool, this->leaves, [&](int leaf){
+        const QuadNode& quad = this->tree.nodes[leaf];
+        const Coefficient* local = this->locals[leaf].terms;
+        int end = quad.begin + quad.count;
+        for(int i = quad.begin; i < end; i++){
+            //The potential sum L_jq t^j conj(t)^q is real, its gradient is 2 d/d(conj t)
+            Coefficient t((double)this->sortedX[i] - quad.comX, (double)this->sortedY[i] - quad.comY);
+            Coefficient powers[P];
+            powers[0] = 1.0;
+            for(int n = 1; n < P; n++){
+                powers[n] = powers[n - 1] * t;
+            }
+            Coefficient gradient = 0.0;
+            for(int j = 0; j < P; j++){
+                for(int q = 1; q < P; q++){
+                    gradient += (double)q * local[j * P + q] * powers[j] * std::conj(powers[q - 1]);
+                }
+            }
+            gradient *= 2.0 * params.g;
+            this->sortedAx[i] = gradient.real();
+            this->sortedAy[i] = gradient.imag();
+        }
+
+        for(int s = this->p2pStart[leaf]; s < this->p2pStart[leaf + 1]; s++){
+            const QuadNode& source = this->tree.nodes[this->p2pSources[s]];
+            this->kernel.sourceSum(params, this->sortedX.data(), this->sortedY.data(), this->sortedMass.data(), this->sortedAx.data(), this->sortedAy.data(),
+                                   quad.begin, end, source.begin, source.begin + source.count);
+        }
+        for(int i = quad.begin; i < end; i++){
+            int body = this->tree.order[i];
+            particles.ax[body] = this->sortedAx[i];
+            particles.ay[body] = this->sortedAy[i];
+        }
+    });
+}
+
+template<int P>
+void FastMultipole<P>::calculateAccelerations(ParticleSystem& particles, float theta, const ForceKernel& kernel, const ForceParams& params, ThreadPool* pool){
+    if(particles.size() == 0){
+        return;
+    }
+    this->kernel = kernel;
+    this->params = params;
+    this->minSeparation = forceFarField(kernel.law, params);
+    {
+        PROFILE_ZONE("QuadTree::build");
+        this->tree.build(particles);
+    }
+    buildLevels();
+
+    size_t count = particles.size();
+    this->sortedX.resize(count);
+    this->sortedY.resize(count);
+    this->sortedMass.resize(count);
+    this->sortedAx.resize(count);
+    this->sortedAy.resize(count);
+    for(size_t i = 0; i < count; i++){
+        int body = this->tree.order[i];
+        this->sortedX[i] = particles.x[body];
+        this->sortedY[i] = particles.y[body];
+        this->sortedMass[i] = particles.mass[body];
+    }
+    upward(particles, pool);
+
+    {
+        PROFILE_ZONE("FastMultipole::walk");
+        this->m2lPairs.clear();
+        this->p2pPairs.clear();
+        interact(0, 0, theta);
+        groupByTarget(this->m2lPairs, this->tree.nodes.size(), this->m2lStart, this->m2lSources);
+        groupByTarget(this->p2pPairs, this->tree.nodes.size(), this->p2pStart, this->p2pSources);
+    }
+
+    downward(particles, pool);
+}
+
+//Orders available to the solver and the benchmarks
+template class FastMultipole<4>;
+template class FastMultipole<6>;
+template class FastMultipole<8>;
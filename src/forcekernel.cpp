@@ -0,0 +1,87 @@
+#include "forcekernel.hpp"
+
+template<class Law>
+void directSumScalar(const ForceParams& params, const float* x, const float* y, const float* mass, float* ax, float* ay, size_t begin, size_t end, size_t count){
+    for(size_t i = begin; i < end; i++){
+        float rowX = 0.0f;
+        float rowY = 0.0f;
+        for(size_t j = i + 1; j < count; j++){
+            directSumPair<ScalarOps, Law>(params, x, y, mass, ax, ay, i, j, rowX, rowY);
+        }
+        ax[i] += rowX;
+        ay[i] += rowY;
+    }
+}
+
+template<class Law>
+void sourceSumScalar(const ForceParams& params, const float* x, const float* y, const float* mass, float* ax, float* ay, size_t begin, size_t end, size_t sourceBegin, size_t sourceEnd){
+    for(size_t i = begin; i < end; i++){
+        float rowX = 0.0f;
+        float rowY = 0.0f;
+        for(size_t j = sourceBegin; j < sourceEnd; j++){
+            sourceSumPair<ScalarOps, Law>(params, x, y, mass, i, j, rowX, rowY);
+        }
+        ax[i] += rowX;
+        ay[i] += rowY;
+    }
+}
+
+template void directSumScalar<NewtonCutoff>(const ForceParams&, const float*, const float*, const float*, float*, float*, size_t, size_t, size_t);
+template void directSumScalar<Plummer>(const ForceParams&, const float*, const float*, const float*, float*, float*, size_t, size_t, size_t);
+template void sourceSumScalar<NewtonCutoff>(const ForceParams&, const float*, const float*, const float*, float*, float*, size_t, size_t, size_t, size_t);
+template void sourceSumScalar<Plummer>(const ForceParams&, const float*, const float*, const float*, float*, float*, size_t, size_t, size_t, size_t);
+
+//Leaves kernel untouched when the CPU cannot run the instruction set
+template<class Law>
+static bool getLawKernel(KernelIsa isa, ForceKernel& kernel){
+    switch(isa){
+        case KernelIsa::Scalar:
+            kernel = {KernelIsa::Scalar, Law::law, "scalar", directSumScalar<Law>, sourceSumScalar<Law>};
+            return true;
+#ifdef FORCE_KERNEL_X86
+        case KernelIsa::SSE2:
+            //Part of the x86-64 baseline, still checked for 32 bit builds
+            __builtin_cpu_init();
+            if(!__builtin_cpu_supports("sse2")){
+                return false;
+            }
+            kernel = {KernelIsa::SSE2, Law::law, "SSE2", directSumSSE2<Law>, sourceSumSSE2<Law>};
+            return true;
+        case KernelIsa::AVX2:
+            __builtin_cpu_init();
+            if(!__builtin_cpu_supports("avx2")){
+                return false;
+            }
+            kernel = {KernelIsa::AVX2, Law::law, "AVX2", directSumAVX2<Law>, sourceSumAVX2<Law>};
+            return true;
+        case KernelIsa::AVX512:
+            __builtin_cpu_init();
+            if(!__builtin_cpu_supports("avx512f")){
+                return false;
+            }
+            kernel = {KernelIsa::AVX512, Law::law, "AVX-512", directSumAVX512<Law>, sourceSumAVX512<Law>};
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+bool getForceKernel(KernelIsa isa, ForceKernel& kernel, ForceLaw law){
+    if(law == ForceLaw::Plummer){
+        return getLawKernel<Plummer>(isa, kernel);
+    }
+    return getLawKernel<NewtonCutoff>(isa, kernel);
+}
+
+ForceKernel selectForceKernel(ForceLaw law){
+    ForceKernel kernel;
+    const KernelIsa preference[] = {KernelIsa::AVX512, KernelIsa::AVX2, KernelIsa::SSE2};
+    for(KernelIsa isa: preference){
+        if(getForceKernel(isa, kernel, law)){
+            return kernel;
+        }
+    }
+    getForceKernel(KernelIsa::Scalar, kernel, law);
+    return kernel;
+}
@@ -0,0 +1,44 @@
+#include <immintrin.h>
+#include "forcekernel_simd.hpp"
+
+namespace {
+
+struct AVX2Ops {
+    typedef __m256 Vec;
+    typedef __m256 Mask;
+    static const size_t width = 8;
+    static Vec set1(float value){ return _mm256_set1_ps(value); }
+    static Vec zero(){ return _mm256_setzero_ps(); }
+    static Vec loadu(const float* p){ return _mm256_loadu_ps(p); }
+    static void storeu(float* p, Vec v){ _mm256_storeu_ps(p, v); }
+    static Vec add(Vec a, Vec b){ return _mm256_add_ps(a, b); }
+    static Vec sub(Vec a, Vec b){ return _mm256_sub_ps(a, b); }
+    static Vec mul(Vec a, Vec b){ return _mm256_mul_ps(a, b); }
+    static Vec div(Vec a, Vec b){ return _mm256_div_ps(a, b); }
+    static Vec sqrt(Vec a){ return _mm256_sqrt_ps(a); }
+    static Mask greaterEqual(Vec a, Vec b){ return _mm256_cmp_ps(a, b, _CMP_GE_OQ); }
+    static Vec maskedDiv(Mask mask, Vec a, Vec b){ return _mm256_and_ps(mask, _mm256_div_ps(a, b)); }
+    static float scalarSqrt(float value){ return _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(value))); }
+    static float reduce(Vec v){
+        float lanes[8];
+        _mm256_storeu_ps(lanes, v);
+        return ((lanes[0] + lanes[1]) + (lanes[2] + lanes[3])) + ((lanes[4] + lanes[5]) + (lanes[6] + lanes[7]));
+    }
+};
+
+}
+
+template<class Law>
+void directSumAVX2(const ForceParams& params, const float* x, const float* y, const float* mass, float* ax, float* ay, size_t begin, size_t end, size_t count){
+    directSumSimd<AVX2Ops, Law>(params, x, y, mass, ax, ay, begin, end, count);
+}
+
+template<class Law>
+void sourceSumAVX2(const ForceParams& params, const float* x, const float* y, const float* mass, float* ax, float* ay, size_t begin, size_t end, size_t sourceBegin, size_t sourceEnd){
+    sourceSumSimd<AVX2Ops, Law>(params, x, y, mass, ax, ay, begin, end, sourceBegin, sourceEnd);
+}
+
+template void directSumAVX2<NewtonCutoff>(const ForceParams&, const float*, const float*, const float*, float*, float*, size_t, size_t, size_t);
+template void directSumAVX2<Plummer>(const ForceParams&, const float*, const float*, const float*, float*, float*, size_t, size_t, size_t);
+template void sourceSumAVX2<NewtonCutoff>(const ForceParams&, const float*, const float*, const float*, float*, float*, size_t, size_t, size_t, size_t);
+template void sourceSumAVX2<Plummer>(const ForceParams&, const float*, const float*, const float*, float*, float*, size_t, size_t, size_t, size_t);
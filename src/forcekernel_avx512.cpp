@@ -0,0 +1,50 @@
+#include <immintrin.h>
+#include "forcekernel_simd.hpp"
+
+namespace {
+
+struct AVX512Ops {
+    typedef __m512 Vec;
+    typedef __mmask16 Mask;
+    static const size_t width = 16;
+    static Vec set1(float value){ return _mm512_set1_ps(value); }
+    static Vec zero(){ return _mm512_setzero_ps(); }
+    static Vec loadu(const float* p){ return _mm512_loadu_ps(p); }
+    static void storeu(float* p, Vec v){ _mm512_storeu_ps(p, v); }
+    static Vec add(Vec a, Vec b){ return _mm512_add_ps(a, b); }
+    static Vec sub(Vec a, Vec b){ return _mm512_sub_ps(a, b); }
+    static Vec mul(Vec a, Vec b){ return _mm512_mul_ps(a, b); }
+    static Vec div(Vec a, Vec b){ return _mm512_div_ps(a, b); }
+    //Zero masked form: GCC 12 builds _mm512_sqrt_ps on an undefined passthrough and warns -Wmaybe-uninitialized
+    static Vec sqrt(Vec a){ return _mm512_maskz_sqrt_ps(0xFFFF, a); }
+    static Mask greaterEqual(Vec a, Vec b){ return _mm512_cmp_ps_mask(a, b, _CMP_GE_OQ); }
+    static Vec maskedDiv(Mask mask, Vec a, Vec b){ return _mm512_maskz_div_ps(mask, a, b); }
+    static float scalarSqrt(float value){ return _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(value))); }
+    static float reduce(Vec v){
+        float lanes[16];
+        _mm512_storeu_ps(lanes, v);
+        for(int step = 8; step > 0; step /= 2){
+            for(int i = 0; i < step; i++){
+                lanes[i] = lanes[i] + lanes[i + step];
+            }
+        }
+        return lanes[0];
+    }
+};
+
+}
+
+template<class Law>
+void directSumAVX512(const ForceParams& params, const float* x, const float* y, const float* mass, float* ax, float* ay, size_t begin, size_t end, size_t count){
+    directSumSimd<AVX512Ops, Law>(params, x, y, mass, ax, ay, begin, end, count);
+}
+
+template<class Law>
+void sourceSumAVX512(const ForceParams& params, const float* x, const float* y, const float* mass, float* ax, float* ay, size_t begin, size_t end, size_t sourceBegin, size_t sourceEnd){
+    sourceSumSimd<AVX512Ops, Law>(params, x, y, mass, ax, ay, begin, end, sourceBegin, sourceEnd);
+}
+
+template void directSumAVX512<NewtonCutoff>(const ForceParams&, const float*, const float*, const float*, float*, float*, size_t, size_t, size_t);
+template void directSumAVX512<Plummer>(const ForceParams&, const float*, const float*, const float*, float*, float*, size_t, size_t, size_t);
+template void sourceSumAVX512<NewtonCutoff>(const ForceParams&, const float*, const float*, const float*, float*, float*, size_t, size_t, size_t, size_t);
+template void sourceSumAVX512<Plummer>(const ForceParams&, const float*, const float*, const float*, float*, float*, size_t, size_t, size_t, size_t);
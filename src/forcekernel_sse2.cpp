@@ -0,0 +1,44 @@
+#include <emmintrin.h>
+#include "forcekernel_simd.hpp"
+
+namespace {
+
+struct SSE2Ops {
+    typedef __m128 Vec;
+    typedef __m128 Mask;
+    static const size_t width = 4;
+    static Vec set1(float value){ return _mm_set1_ps(value); }
+    static Vec zero(){ return _mm_setzero_ps(); }
+    static Vec loadu(const float* p){ return _mm_loadu_ps(p); }
+    static void storeu(float* p, Vec v){ _mm_storeu_ps(p, v); }
+    static Vec add(Vec a, Vec b){ return _mm_add_ps(a, b); }
+    static Vec sub(Vec a, Vec b){ return _mm_sub_ps(a, b); }
+    static Vec mul(Vec a, Vec b){ return _mm_mul_ps(a, b); }
+    static Vec div(Vec a, Vec b){ return _mm_div_ps(a, b); }
+    static Vec sqrt(Vec a){ return _mm_sqrt_ps(a); }
+    static Mask greaterEqual(Vec a, Vec b){ return _mm_cmpge_ps(a, b); }
+    static Vec maskedDiv(Mask mask, Vec a, Vec b){ return _mm_and_ps(mask, _mm_div_ps(a, b)); }
+    static float scalarSqrt(float value){ return _mm_cvtss_f32(_mm_sqrt_ss(_mm_set_ss(value))); }
+    static float reduce(Vec v){
+        float lanes[4];
+        _mm_storeu_ps(lanes, v);
+        return (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+    }
+};
+
+}
+
+template<class Law>
+void directSumSSE2(const ForceParams& params, const float* x, const float* y, const float* mass, float* ax, float* ay, size_t begin, size_t end, size_t count){
+    directSumSimd<SSE2Ops, Law>(params, x, y, mass, ax, ay, begin, end, count);
+}
+
+template<class Law>
+void sourceSumSSE2(const ForceParams& params, const float* x, const float* y, const float* mass, float* ax, float* ay, size_t begin, size_t end, size_t sourceBegin, size_t sourceEnd){
+    sourceSumSimd<SSE2Ops, Law>(params, x, y, mass, ax, ay, begin, end, sourceBegin, sourceEnd);
+}
+
+template void directSumSSE2<NewtonCutoff>(const ForceParams&, const float*, const float*, const float*, float*, float*, size_t, size_t, size_t);
+template void directSumSSE2<Plummer>(const ForceParams&, const float*, const float*, const float*, float*, float*, size_t, size_t, size_t);
+template void sourceSumSSE2<NewtonCutoff>(const ForceParams&, const float*, const float*, const float*, float*, float*, size_t, size_t, size_t, size_t);
+template void sourceSumSSE2<Plummer>(const ForceParams&, const float*, const float*, const float*, float*, float*, size_t, size_t, size_t, size_t);
@@ -0,0 +1,43 @@
+#include "geometry.hpp"
+#include <cmath>
+
+std::vector<float> circleVertices(Pos pos, float radius, unsigned int numElements){
+    std::vector<float> vertices;
+    vertices.reserve((numElements + 1) * 3);
+    float angleStep = 2 * PI / numElements;
+    vertices.push_back(pos.x);
+    vertices.push_back(pos.y);
+    vertices.push_back(0.0f);
+    for(unsigned int i = 0; i < numElements; i++){
+        float angle = i * angleStep;
+        vertices.push_back(pos.x + radius * std::cos(angle));
+        vertices.push_back(pos.y + radius * std::sin(angle));
+        vertices.push_back(0.0f);
+    }
+    return vertices;
+}
+
+std::vector<unsigned int> circleIndices(unsigned int numElements){
+    std::vector<unsigned int> indices;
+    indices.reserve(numElements * 3);
+    for(unsigned int i = 0; i < numElements; i++){
+        indices.push_back(0);
+        indices.push_back(i + 1);
+        indices.push_back((i + 1) % numElements + 1);
+    }
+    return indices;
+}
+
+unsigned int circleLodSegments(unsigned int lod){
+    return CIRCLE_LOD_MIN_SEGMENTS << lod;
+}
+
+unsigned int circleLod(float pixelRadius){
+    //A chord of n segments sags r (1 - cos(pi / n)), about r pi^2 / (2 n^2), below the rim
+    float segments = PI * std::sqrt(std::fmax(pixelRadius, 0.0f) / (2 * CIRCLE_LOD_TOLERANCE));
+    unsigned int lod = 0;
+    while(lod + 1 < CIRCLE_LOD_COUNT && circleLodSegments(lod) < segments){
+        lod++;
+    }
+    return lod;
+}
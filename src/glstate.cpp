@@ -0,0 +1,100 @@
+#include "glstate.hpp"
+
+GLStateCache::GLStateCache(){
+    invalidate();
+    this->issuedCalls = 0;
+    this->skippedCalls = 0;
+    this->lastFrameIssuedCalls = 0;
+    this->lastFrameSkippedCalls = 0;
+}
+
+void GLStateCache::useProgram(unsigned int program){
+    if(program == this->program){
+        this->skippedCalls++;
+        return;
+    }
+    glUseProgram(program);
+    this->program = program;
+    this->issuedCalls++;
+}
+
+void GLStateCache::bindVertexArray(unsigned int vao){
+    if(vao == this->vao){
+        this->skippedCalls++;
+        return;
+    }
+    glBindVertexArray(vao);
+    this->vao = vao;
+    this->elementBufferKnown = false;
+    this->issuedCalls++;
+}
+
+void GLStateCache::bindBuffer(GLenum target, unsigned int buffer){
+    if(target == GL_ARRAY_BUFFER){
+        if(buffer == this->arrayBuffer){
+            this->skippedCalls++;
+            return;
+        }
+        this->arrayBuffer = buffer;
+    }else if(target == GL_ELEMENT_ARRAY_BUFFER){
+        if(this->elementBufferKnown && buffer == this->elementBuffer){
+            this->skippedCalls++;
+            return;
+        }
+        this->elementBuffer = buffer;
+        this->elementBufferKnown = true;
+    }
+    glBindBuffer(target, buffer);
+    this->issuedCalls++;
+}
+
+//Deleting a bound object unbinds it and its name can be handed out again, so drop it from the cache
+void GLStateCache::deleteVertexArray(unsigned int vao){
+    if(vao == this->vao){
+        this->vao = 0;
+        this->elementBufferKnown = false;
+    }
+    glDeleteVertexArrays(1, &vao);
+}
+
+void GLStateCache::deleteBuffer(unsigned int buffer){
+    if(buffer == this->arrayBuffer){
+        this->arrayBuffer = 0;
+    }
+    if(buffer == this->elementBuffer){
+        this->elementBufferKnown = false;
+    }
+    glDeleteBuffers(1, &buffer);
+}
+
+void GLStateCache::deleteProgram(unsigned int program){
+    //A program in use stays current until something else is used
+    if(program == this->program){
+        this->program = ~0u;
+    }
+    glDeleteProgram(program);
+}
+
+void GLStateCache::invalidate(){
+    //Names no GL object can have, so the next bind of anything goes through
+    this->program = ~0u;
+    this->vao = ~0u;
+    this->arrayBuffer = ~0u;
+    this->elementBuffer = ~0u;
+    this->elementBufferKnown = false;
+}
+
+void GLStateCache::beginFrame(){
+    this->lastFrameIssuedCalls = this->issuedCalls;
+    this->lastFrameSkippedCalls = this->skippedCalls;
+    this->issuedCalls = 0;
+    this->skippedCalls = 0;
+}
+
+unsigned int GLStateCache::getLastFrameIssuedCalls() const{
+    return this->lastFrameIssuedCalls;
+}
+
+unsigned int GLStateCache::getLastFrameSkippedCalls() const{
+    return this->lastFrameSkippedCalls;
+}
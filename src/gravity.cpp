@@ -0,0 +1,190 @@
+#include "gravity.hpp"
+#include <algorithm>
+#include "profiler.hpp"
+
+GravitySolver::GravitySolver(ForceSolver solver, float theta, ThreadPool* pool){
+    this->solver = solver;
+    this->theta = theta;
+    this->kernel = selectForceKernel();
+    this->pool = pool;
+    this->params = {(float)G_CONST, MIN_DISTANCE_THRESHOLD, PLUMMER_SOFTENING * PLUMMER_SOFTENING};
+    this->softening = PLUMMER_SOFTENING;
+}
+
+void GravitySolver::setForceLaw(ForceLaw law, float softening){
+    //Keep the instruction set, only the law's instance of the kernels changes
+    getForceKernel(this->kernel.isa, this->kernel, law);
+    this->params.softeningSquared = softening * softening;
+    this->softening = softening;
+}
+
+ForceLaw GravitySolver::getForceLaw() const{
+    return this->kernel.law;
+}
+
+float GravitySolver::getSoftening() const{
+    return this->softening;
+}
+
+ForceParams GravitySolver::getForceParams() const{
+    return this->params;
+}
+
+void GravitySolver::calculateAccelerations(ParticleSystem& particles){
+    PROFILE_ZONE("GravitySolver::calculateAccelerations");
+    if(this->solver == ForceSolver::BarnesHut){
+        barnesHut(particles);
+    }else if(this->solver == ForceSolver::ParticleMesh){
+        this->mesh.calculateAccelerations(particles, this->kernel.law, this->params, this->pool);
+    }else if(this->solver == ForceSolver::FastMultipole){
+        this->multipole.calculateAccelerations(particles, this->theta, this->kernel, this->params, this->pool);
+    }else{
+        directSum(particles);
+    }
+}
+
+//Number of pairs (i, j > i) in the rows before row
+static double pairsBefore(size_t row, size_t count){
+    return (double)row * (count - 1) - (double)row * (row - 1) / 2;
+}
+
+void GravitySolver::directSum(ParticleSystem& particles){
+    size_t count = particles.size();
+    const ForceParams& params = this->params;
+    const float* x = particles.x.data();
+    const float* y = particles.y.data();
+    const float* mass = particles.mass.data();
+
+    unsigned int blocks = (this->pool != nullptr && count >= PARALLEL_MIN_BODIES) ? this->pool->getThreadCount() : 1;
+    if(blocks == 1){
+        std::fill(particles.ax.begin(), particles.ax.end(), 0.0f);
+        std::fill(particles.ay.begin(), particles.ay.end(), 0.0f);
+        this->kernel.directSum(params, x, y, mass, particles.ax.data(), particles.ay.data(), 0, count, count);
+        return;
+    }
+
+    //Row blocks with an equal share of the pairs, later rows have fewer partners so they get more rows
+    this->rowStart.resize(blocks + 1);
+    double totalPairs = pairsBefore(count, count);
+    for(unsigned int block = 0; block <= blocks; block++){
+        double target = totalPairs * block / blocks;
+        size_t low = 0, high = count;
+        while(low < high){
+            size_t middle = (low + high) / 2;
+            if(pairsBefore(middle, count) < target){
+                low = middle + 1;
+            }else{
+                high = middle;
+            }
+        }
+        this->rowStart[block] = low;
+    }
+    this->rowStart[blocks] = count;
+
+    //Each block writes both sides of its pairs into its own accumulator, rows only reach bodies at or after their start
+    this->accumulatorX.resize(blocks);
+    this->accumulatorY.resize(blocks);
+    this->pool->run(blocks, [&](unsigned int block, unsigned int){
+        PROFILE_ZONE("directSum block");
+        std::vector<float>& accX = this->accumulatorX[block];
+        std::vector<float>& accY = this->accumulatorY[block];
+        accX.resize(count);
+        accY.resize(count);
+        size_t begin = this->rowStart[block];
+        std::fill(accX.begin() + begin, accX.end(), 0.0f);
+        std::fill(accY.begin() + begin, accY.end(), 0.0f);
+        this->kernel.directSum(params, x, y, mass, accX.data(), accY.data(), begin, this->rowStart[block + 1], count);
+    });
+
+    //Reduce in block order so the result does not depend on which thread ran which block
+    float* ax = particles.ax.data();
+    float* ay = particles.ay.data();
+    size_t chunk = (count + blocks - 1) / blocks;
+    this->pool->run(blocks, [&](unsigned int part, unsigned int){
+        PROFILE_ZONE("directSum reduce");
+        size_t end = std::min(count, (part + 1) * chunk);
+        for(size_t i = part * chunk; i < end; i++){
+            float sumX = 0.0f, sumY = 0.0f;
+            for(unsigned int block = 0; block < blocks && this->rowStart[block] <= i; block++){
+                sumX += this->accumulatorX[block][i];
+                sumY += this->accumulatorY[block][i];
+            }
+            ax[i] = sumX;
+            ay[i] = sumY;
+        }
+    });
+}
+
+void GravitySolver::barnesHut(ParticleSystem& particles){
+    {
+        PROFILE_ZONE("QuadTree::build");
+        this->tree.build(particles);
+    }
+    //Picked once per pass, the walk itself is specialized for the law
+    if(this->kernel.law == ForceLaw::Plummer){
+        barnesHutWalk<Plummer>(particles);
+    }else{
+        barnesHutWalk<NewtonCutoff>(particles);
+    }
+}
+
+template<class Law>
+void GravitySolver::barnesHutWalk(ParticleSystem& particles){
+    size_t count = particles.size();
+    unsigned int threads = this->pool != nullptr ? this->pool->getThreadCount() : 1;
+    this->stacks.resize(threads);
+    unsigned int blocks = (count + BARNES_HUT_BLOCK - 1) / BARNES_HUT_BLOCK;
+    auto walk = [&](unsigned int block, unsigned int thread){
+        PROFILE_ZONE("barnesHut block");
+        size_t end = std::min(count, (size_t)(block + 1) * BARNES_HUT_BLOCK);
+        for(size_t i = (size_t)block * BARNES_HUT_BLOCK; i < end; i++){
+            Vector2D acceleration = this->tree.calculateAcceleration<Law>(particles, i, this->theta, this->params, this->stacks[thread]);
+            particles.ax[i] = acceleration.x;
+            particles.ay[i] = acceleration.y;
+        }
+    };
+    if(threads > 1 && count >= PARALLEL_MIN_BODIES){
+        this->pool->run(blocks, walk);
+    }else{
+        for(unsigned int block = 0; block < blocks; block++){
+            walk(block, 0);
+        }
+    }
+}
+
+double GravitySolver::calculateEnergy(const ParticleSystem& particles){
+    double kinetic = 0.0;
+    for(size_t i = 0; i < particles.size(); i++){
+        kinetic += 0.5 * particles.mass[i] * ((double)particles.vx[i] * particles.vx[i] + (double)particles.vy[i] * particles.vy[i]);
+    }
+    if(this->kernel.law == ForceLaw::Plummer){
+        return kinetic + potentialEnergy<Plummer>(particles);
+    }
+    return kinetic + potentialEnergy<NewtonCutoff>(particles);
+}
+
+template<class Law>
+double GravitySolver::potentialEnergy(const ParticleSystem& particles){
+    double potential = 0.0;
+    for(size_t i = 0; i < particles.size(); i++){
+        for(size_t j = i + 1; j < particles.size(); j++){
+            double dx = particles.x[j] - particles.x[i];
+            double dy = particles.y[j] - particles.y[i];
+            potential += Law::potential(this->params, dx * dx + dy * dy) * particles.mass[i] * particles.mass[j];
+        }
+    }
+    return potential;
+}
+
+const char* GravitySolver::getName(){
+    switch(this->solver){
+        case ForceSolver::BarnesHut:
+            return "Barnes-Hut";
+        case ForceSolver::ParticleMesh:
+            return "Particle mesh";
+        case ForceSolver::FastMultipole:
+            return "Fast multipole";
+        default:
+            return "Direct sum";
+    }
+}
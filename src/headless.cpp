@@ -0,0 +1,270 @@
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <cmath>
+#include "checkpoint.hpp"
+#include "gravity.hpp"
+#include "profiler.hpp"
+#include "scene.hpp"
+#include "simulation.hpp"
+#include "trajectory.hpp"
+
+/*
+ * Runs the simulation without GLFW or an OpenGL context as fast as the CPU allows and writes the
+ * final state to disk. For compute nodes with no display.
+ */
+
+void printUsage(){
+    std::cout << "Usage: 2d-render-headless [options]\n"
+              << "  --bodies N       disk scene with N bodies (default: the solar system)\n"
+              << "  --seed N         random seed for the disk scene\n"
+              << "  --load FILE      resume from a checkpoint instead of building a scene\n"
+              << "  --steps N        steps to run (default 1000)\n"
+              << "  --threads N      force pass threads (default: every hardware thread)\n"
+              << "  --solver NAME    direct, barnes-hut, pm (particle mesh) or fmm (fast multipole)\n"
+              << "  --theta X        Barnes-Hut and fast multipole opening angle, in (0, 1]\n"
+              << "  --integrator NAME euler, leapfrog, verlet or yoshida (default leapfrog)\n"
+              << "  --dt X           simulation time per step\n"
+              << "  --softening X    Plummer softened gravity with length X instead of the hard cutoff\n"
+              << "  --sort-interval N steps between Morton sorts of the bodies, 0 never sorts (default 32)\n"
+              << "  --no-merge       let bodies pass through each other instead of merging\n"
+              << "  --energy         print the relative energy drift (O(N^2), merging loses energy)\n"
+              << "  --output FILE    final state as CSV (default headless.csv)\n"
+              << "  --checkpoint FILE binary checkpoint of the final state, loadable with --load\n"
+              << "  --checkpoint-every N also write the checkpoint every N steps\n"
+              << "  --trajectory FILE positions every --trajectory-every steps, written by a background thread\n"
+              << "  --trajectory-every N record every N-th step (default 1)\n"
+              << "  --trajectory-ids LIST comma separated body ids to record (default: every body)\n"
+              << "  --trajectory-delta X delta + varint encode positions rounded to X units (default: raw floats)\n"
+              << "  --trace FILE     timing zones as Chrome trace JSON (needs -DENABLE_PROFILER=ON)\n";
+}
+
+bool writeState(const ParticleSystem& particles, const char* path){
+    std::ofstream file(path);
+    if(!file.is_open()){
+        return false;
+    }
+    file << "name,mass,x,y,vx,vy\n";
+    for(size_t i = 0; i < particles.size(); i++){
+        file << particles.planets[i].name << "," << particles.mass[i] << ","
+             << particles.x[i] << "," << particles.y[i] << ","
+             << particles.vx[i] << "," << particles.vy[i] << "\n";
+    }
+    return file.good();
+}
+
+int main(int argc, char** argv){
+    /* Command line */
+    size_t bodies = 0;
+    unsigned int seed = 1;
+    unsigned long steps = 1000;
+    unsigned int threadCount = 0;
+    ForceSolver forceSolver = ForceSolver::DirectSum;
+    float theta = BARNES_HUT_THETA;
+    IntegratorType integratorType = IntegratorType::Leapfrog;
+    bool integratorSet = false; //A loaded checkpoint keeps its own integrator and step size unless overridden
+    float stepSize = SIM_STEP;
+    bool stepSizeSet = false;
+    float softening = 0.0f;
+    bool merge = true;
+    unsigned int sortInterval = SIM_SORT_INTERVAL;
+    bool energy = false;
+    const char* output = "headless.csv";
+    const char* trace = nullptr;
+    const char* load = nullptr;
+    const char* checkpoint = nullptr;
+    unsigned long checkpointEvery = 0;
+    const char* trajectory = nullptr;
+    unsigned int trajectoryEvery = 1;
+    std::vector<unsigned int> trajectoryIds; //Empty records every body
+    double trajectoryQuantum = 0.0; //0 writes raw floats
+    for(int i = 1; i < argc; i++){
+        bool hasValue = i + 1 < argc;
+        if(std::strcmp(argv[i], "--bodies") == 0 && hasValue){
+            bodies = std::strtoul(argv[++i], nullptr, 10);
+        }else if(std::strcmp(argv[i], "--seed") == 0 && hasValue){
+            seed = std::strtoul(argv[++i], nullptr, 10);
+        }else if(std::strcmp(argv[i], "--steps") == 0 && hasValue){
+            steps = std::strtoul(argv[++i], nullptr, 10);
+        }else if(std::strcmp(argv[i], "--threads") == 0 && hasValue){
+            threadCount = std::strtoul(argv[++i], nullptr, 10);
+        }else if(std::strcmp(argv[i], "--solver") == 0 && hasValue){
+            i++;
+            if(std::strcmp(argv[i], "barnes-hut") == 0){
+                forceSolver = ForceSolver::BarnesHut;
+            }else if(std::strcmp(argv[i], "pm") == 0){
+                forceSolver = ForceSolver::ParticleMesh;
+            }else if(std::strcmp(argv[i], "fmm") == 0){
+                forceSolver = ForceSolver::FastMultipole;
+            }else if(std::strcmp(argv[i], "direct") != 0){
+                std::cerr << "Unknown solver " << argv[i] << std::endl;
+                return 1;
+            }
+        }else if(std::strcmp(argv[i], "--theta") == 0 && hasValue){
+            theta = std::atof(argv[++i]);
+            if(!(theta > 0.0f && theta <= BARNES_HUT_MAX_THETA)){
+                std::cerr << "Theta must be above 0 and at most " << BARNES_HUT_MAX_THETA << std::endl;
+                return 1;
+            }
+        }else if(std::strcmp(argv[i], "--load") == 0 && hasValue){
+            load = argv[++i];
+        }else if(std::strcmp(argv[i], "--integrator") == 0 && hasValue){
+            i++;
+            integratorSet = true;
+            if(std::strcmp(argv[i], "euler") == 0){
+                integratorType = IntegratorType::Euler;
+            }else if(std::strcmp(argv[i], "verlet") == 0){
+                integratorType = IntegratorType::VelocityVerlet;
+            }else if(std::strcmp(argv[i], "yoshida") == 0){
+                integratorType = IntegratorType::Yoshida4;
+            }else if(std::strcmp(argv[i], "leapfrog") != 0){
+                std::cerr << "Unknown integrator " << argv[i] << std::endl;
+                return 1;
+            }
+        }else if(std::strcmp(argv[i], "--dt") == 0 && hasValue){
+            stepSize = std::atof(argv[++i]);
+            stepSizeSet = true;
+        }else if(std::strcmp(argv[i], "--softening") == 0 && hasValue){
+            softening = std::atof(argv[++i]);
+            if(!(softening > 0.0f)){
+                std::cerr << "Softening must be above 0" << std::endl;
+                return 1;
+            }
+        }else if(std::strcmp(argv[i], "--sort-interval") == 0 && hasValue){
+            sortInterval = std::strtoul(argv[++i], nullptr, 10);
+        }else if(std::strcmp(argv[i], "--no-merge") == 0){
+            merge = false;
+        }else if(std::strcmp(argv[i], "--energy") == 0){
+            energy = true;
+        }else if(std::strcmp(argv[i], "--output") == 0 && hasValue){
+            output = argv[++i];
+        }else if(std::strcmp(argv[i], "--checkpoint") == 0 && hasValue){
+            checkpoint = argv[++i];
+        }else if(std::strcmp(argv[i], "--checkpoint-every") == 0 && hasValue){
+            checkpointEvery = std::strtoul(argv[++i], nullptr, 10);
+        }else if(std::strcmp(argv[i], "--trajectory") == 0 && hasValue){
+            trajectory = argv[++i];
+        }else if(std::strcmp(argv[i], "--trajectory-every") == 0 && hasValue){
+            trajectoryEvery = std::strtoul(argv[++i], nullptr, 10);
+        }else if(std::strcmp(argv[i], "--trajectory-ids") == 0 && hasValue){
+            char* next = argv[++i];
+            while(*next != '\0'){
+                trajectoryIds.push_back(std::strtoul(next, &next, 10));
+                next += *next == ',';
+            }
+        }else if(std::strcmp(argv[i], "--trajectory-delta") == 0 && hasValue){
+            trajectoryQuantum = std::atof(argv[++i]);
+            if(!(trajectoryQuantum > 0.0)){
+                std::cerr << "Trajectory quantum must be above 0" << std::endl;
+                return 1;
+            }
+        }else if(std::strcmp(argv[i], "--trace") == 0 && hasValue){
+            trace = argv[++i];
+        }else{
+            printUsage();
+            return std::strcmp(argv[i], "--help") == 0 ? 0 : 1;
+        }
+    }
+
+    /* Physics */
+    setProfilerThreadName("main");
+    ThreadPool pool(threadCount);
+    GravitySolver solver = GravitySolver(forceSolver, theta, &pool);
+    if(softening > 0.0f){
+        solver.setForceLaw(ForceLaw::Plummer, softening);
+    }
+    Simulation simulation = Simulation(&solver, integratorType);
+    simulation.stepSize = stepSize;
+    simulation.mergeCollisions = merge;
+    simulation.sortInterval = sortInterval;
+    if(load != nullptr){
+        //The checkpoint brings its bodies, time, integrator state and force law; the command line only overrides
+        if(!loadCheckpoint(load, simulation)){
+            return 1;
+        }
+        if(integratorSet){
+            simulation.setIntegrator(integratorType);
+        }
+        if(stepSizeSet){
+            simulation.stepSize = stepSize;
+        }
+        if(!merge){
+            simulation.mergeCollisions = false;
+        }
+        if(softening > 0.0f){
+            solver.setForceLaw(ForceLaw::Plummer, softening);
+            simulation.integrator->reset();
+        }
+        std::cout << "Resuming " << load << " at step " << simulation.steps << ", time " << simulation.time << std::endl;
+    }else if(bodies > 0){
+        loadDisk(simulation.particles, bodies, seed);
+    }else{
+        loadSolarSystem(simulation.particles);
+    }
+    if(checkpointEvery > 0 && checkpoint == nullptr){
+        std::cerr << "--checkpoint-every needs --checkpoint FILE" << std::endl;
+        return 1;
+    }
+    std::cout << simulation.particles.size() << " bodies, " << solver.getName() << ", " << forceLawName(solver.getForceLaw())
+              << ", " << simulation.integrator->getName()
+              << ", force kernel: " << solver.kernel.name << ", " << pool.getThreadCount() << " threads" << std::endl;
+    double initialEnergy = energy ? solver.calculateEnergy(simulation.particles) : 0.0;
+
+    TrajectoryRecorder recorder;
+    if(trajectory != nullptr){
+        TrajectoryEncoding encoding = trajectoryQuantum > 0.0 ? TrajectoryEncoding::DeltaVarint : TrajectoryEncoding::Raw;
+        if(!recorder.open(trajectory, simulation, trajectoryEvery, trajectoryIds, encoding, trajectoryQuantum)){
+            return 1;
+        }
+    }
+
+    /* Run */
+    std::chrono::time_point<std::chrono::high_resolution_clock> start = std::chrono::high_resolution_clock::now();
+    for(unsigned long i = 0; i < steps; i++){
+        simulation.step();
+        recorder.record(simulation);
+        if(checkpointEvery > 0 && (i + 1) % checkpointEvery == 0 && i + 1 < steps && !saveCheckpoint(simulation, checkpoint)){
+            return 1;
+        }
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - start).count();
+    std::cout << steps << " steps in " << seconds << " s (" << steps / seconds << " steps/s)" << std::endl;
+    if(trajectory != nullptr){
+        if(!recorder.close()){
+            std::cerr << "Error: Unable to write " << trajectory << std::endl;
+            return 1;
+        }
+        std::cout << "Wrote " << trajectory << ": " << recorder.getFrames() << " frames, " << recorder.getBytes() << " bytes, "
+                  << recorder.getStalls() << " waits for the disk" << std::endl;
+    }
+    if(simulation.merges > 0){
+        std::cout << simulation.merges << " bodies merged, " << simulation.particles.size() << " left" << std::endl;
+    }
+    if(energy){
+        double finalEnergy = solver.calculateEnergy(simulation.particles);
+        std::cout << "Relative energy drift: " << (finalEnergy - initialEnergy) / std::fabs(initialEnergy) << std::endl;
+    }
+
+    if(!writeState(simulation.particles, output)){
+        std::cerr << "Error: Unable to write " << output << std::endl;
+        return 1;
+    }
+    std::cout << "Wrote " << output << std::endl;
+    if(checkpoint != nullptr){
+        if(!saveCheckpoint(simulation, checkpoint)){
+            return 1;
+        }
+        std::cout << "Wrote " << checkpoint << std::endl;
+    }
+
+    if(trace != nullptr){
+        if(!writeChromeTrace(trace)){
+            std::cerr << "Error: Unable to write " << trace << ", is the profiler enabled (-DENABLE_PROFILER=ON)?" << std::endl;
+            return 1;
+        }
+        std::cout << "Wrote " << trace << std::endl;
+    }
+    return 0;
+}
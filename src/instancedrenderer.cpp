@@ -0,0 +1,180 @@
+#include "instancedrenderer.hpp"
+#include <algorithm>
+#include <cstddef>
+#include <glm/gtc/type_ptr.hpp>
+#include "geometry.hpp"
+
+InstancedCircleRenderer::InstancedCircleRenderer(const ShaderProgram& shader, GLStateCache& state){
+    this->shader = &shader;
+    this->state = &state;
+    this->cameraLocation = shader.getUniformLocation("camera");
+    this->instanceCapacity = 0;
+
+    //Every level's unit circle in one vertex and one index buffer, indices already offset to their vertices
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    for(unsigned int lod = 0; lod < CIRCLE_LOD_COUNT; lod++){
+        unsigned int segments = circleLodSegments(lod);
+        unsigned int firstVertex = vertices.size() / 3;
+        std::vector<float> lodVertices = circleVertices({0.0f, 0.0f}, 1.0f, segments);
+        std::vector<unsigned int> lodIndices = circleIndices(segments);
+        this->lodFirstIndex[lod] = indices.size();
+        this->lodIndexCount[lod] = lodIndices.size();
+        vertices.insert(vertices.end(), lodVertices.begin(), lodVertices.end());
+        for(unsigned int index: lodIndices){
+            indices.push_back(firstVertex + index);
+        }
+    }
+
+    glGenVertexArrays(1, &this->vao);
+    state.bindVertexArray(this->vao);
+
+    //Unit circles, shared by every instance
+    int positionLocation = shader.getAttributeLocation("aPos");
+    glGenBuffers(1, &this->meshVbo);
+    state.bindBuffer(GL_ARRAY_BUFFER, this->meshVbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glVertexAttribPointer(positionLocation, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(positionLocation);
+
+    glGenBuffers(1, &this->ebo);
+    state.bindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+    //Offset, radius and color advance once per instance, pointed at each level's range when drawing
+    this->offsetLocation = shader.getAttributeLocation("aOffset");
+    this->radiusLocation = shader.getAttributeLocation("aRadius");
+    this->colorLocation = shader.getAttributeLocation("aColor");
+    glGenBuffers(1, &this->instanceVbo);
+    state.bindBuffer(GL_ARRAY_BUFFER, this->instanceVbo);
+    for(int location: {this->offsetLocation, this->radiusLocation, this->colorLocation}){
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+}
+
+InstancedCircleRenderer::~InstancedCircleRenderer(){
+    this->state->deleteVertexArray(this->vao);
+    this->state->deleteBuffer(this->meshVbo);
+    this->state->deleteBuffer(this->ebo);
+    this->state->deleteBuffer(this->instanceVbo);
+}
+
+void InstancedCircleRenderer::clear(){
+    this->instances.clear();
+}
+
+void InstancedCircleRenderer::add(float x, float y, float radius, RGB color){
+    this->instances.push_back({x, y, radius, color.r, color.g, color.b});
+}
+
+void InstancedCircleRenderer::render(const glm::mat4& camera, const glm::vec2& pixelSize){
+    if(this->instances.empty()){
+        return;
+    }
+
+    //Counting sort by level, so every level is one contiguous range of the instance buffer
+    size_t count = this->instances.size();
+    float pixelsPerUnit = 1.0f / std::min(pixelSize.x, pixelSize.y);
+    size_t lodStart[CIRCLE_LOD_COUNT + 1] = {};
+    this->lods.resize(count);
+    for(size_t i = 0; i < count; i++){
+        this->lods[i] = circleLod(this->instances[i].radius * pixelsPerUnit);
+        lodStart[this->lods[i] + 1]++;
+    }
+    for(unsigned int lod = 0; lod < CIRCLE_LOD_COUNT; lod++){
+        lodStart[lod + 1] += lodStart[lod];
+    }
+    size_t cursor[CIRCLE_LOD_COUNT];
+    std::copy(lodStart, lodStart + CIRCLE_LOD_COUNT, cursor);
+    this->sorted.resize(count);
+    for(size_t i = 0; i < count; i++){
+        this->sorted[cursor[this->lods[i]]++] = this->instances[i];
+    }
+
+    //Orphan last frame's storage so the upload does not wait on the draw still reading it
+    this->state->bindBuffer(GL_ARRAY_BUFFER, this->instanceVbo);
+    this->instanceCapacity = std::max(this->instanceCapacity, this->sorted.capacity());
+    glBufferData(GL_ARRAY_BUFFER, this->instanceCapacity * sizeof(CircleInstance), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, count * sizeof(CircleInstance), this->sorted.data());
+
+    this->state->useProgram(this->shader->id);
+    glUniformMatrix4fv(this->cameraLocation, 1, GL_FALSE, glm::value_ptr(camera));
+    this->state->bindVertexArray(this->vao);
+    for(unsigned int lod = 0; lod < CIRCLE_LOD_COUNT; lod++){
+        size_t instances = lodStart[lod + 1] - lodStart[lod];
+        if(instances == 0){
+            continue;
+        }
+        size_t base = lodStart[lod] * sizeof(CircleInstance);
+        glVertexAttribPointer(this->offsetLocation, 2, GL_FLOAT, GL_FALSE, sizeof(CircleInstance), (void*)(base + offsetof(CircleInstance, x)));
+        glVertexAttribPointer(this->radiusLocation, 1, GL_FLOAT, GL_FALSE, sizeof(CircleInstance), (void*)(base + offsetof(CircleInstance, radius)));
+        glVertexAttribPointer(this->colorLocation, 3, GL_FLOAT, GL_FALSE, sizeof(CircleInstance), (void*)(base + offsetof(CircleInstance, r)));
+        glDrawElementsInstanced(GL_TRIANGLES, this->lodIndexCount[lod], GL_UNSIGNED_INT,
+                                (void*)(this->lodFirstIndex[lod] * sizeof(unsigned int)), instances);
+    }
+}
+
+SdfCircleRenderer::SdfCircleRenderer(const ShaderProgram& shader, GLStateCache& state){
+    this->shader = &shader;
+    this->state = &state;
+    this->cameraLocation = shader.getUniformLocation("camera");
+    this->pixelSizeLocation = shader.getUniformLocation("pixelSize");
+    this->instanceCapacity = 0;
+
+    glGenVertexArrays(1, &this->vao);
+    state.bindVertexArray(this->vao);
+
+    //Corners of the unit square as a triangle strip, shared by every instance
+    const float corners[] = {-1.0f, -1.0f, 1.0f, -1.0f, -1.0f, 1.0f, 1.0f, 1.0f};
+    int cornerLocation = shader.getAttributeLocation("aCorner");
+    glGenBuffers(1, &this->cornerVbo);
+    state.bindBuffer(GL_ARRAY_BUFFER, this->cornerVbo);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(corners), corners, GL_STATIC_DRAW);
+    glVertexAttribPointer(cornerLocation, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(cornerLocation);
+
+    int offsetLocation = shader.getAttributeLocation("aOffset");
+    int radiusLocation = shader.getAttributeLocation("aRadius");
+    int colorLocation = shader.getAttributeLocation("aColor");
+    glGenBuffers(1, &this->instanceVbo);
+    state.bindBuffer(GL_ARRAY_BUFFER, this->instanceVbo);
+    glVertexAttribPointer(offsetLocation, 2, GL_FLOAT, GL_FALSE, sizeof(CircleInstance), (void*)offsetof(CircleInstance, x));
+    glVertexAttribPointer(radiusLocation, 1, GL_FLOAT, GL_FALSE, sizeof(CircleInstance), (void*)offsetof(CircleInstance, radius));
+    glVertexAttribPointer(colorLocation, 3, GL_FLOAT, GL_FALSE, sizeof(CircleInstance), (void*)offsetof(CircleInstance, r));
+    for(int location: {offsetLocation, radiusLocation, colorLocation}){
+        glEnableVertexAttribArray(location);
+        glVertexAttribDivisor(location, 1);
+    }
+}
+
+SdfCircleRenderer::~SdfCircleRenderer(){
+    this->state->deleteVertexArray(this->vao);
+    this->state->deleteBuffer(this->cornerVbo);
+    this->state->deleteBuffer(this->instanceVbo);
+}
+
+void SdfCircleRenderer::clear(){
+    this->instances.clear();
+}
+
+void SdfCircleRenderer::add(float x, float y, float radius, RGB color){
+    this->instances.push_back({x, y, radius, color.r, color.g, color.b});
+}
+
+void SdfCircleRenderer::render(const glm::mat4& camera, const glm::vec2& pixelSize){
+    if(this->instances.empty()){
+        return;
+    }
+
+    this->state->bindBuffer(GL_ARRAY_BUFFER, this->instanceVbo);
+    this->instanceCapacity = std::max(this->instanceCapacity, this->instances.capacity());
+    glBufferData(GL_ARRAY_BUFFER, this->instanceCapacity * sizeof(CircleInstance), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, this->instances.size() * sizeof(CircleInstance), this->instances.data());
+
+    this->state->useProgram(this->shader->id);
+    glUniformMatrix4fv(this->cameraLocation, 1, GL_FALSE, glm::value_ptr(camera));
+    glUniform2f(this->pixelSizeLocation, pixelSize.x, pixelSize.y);
+    this->state->bindVertexArray(this->vao);
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, this->instances.size());
+}
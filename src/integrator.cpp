@@ -0,0 +1,140 @@
+#include "integrator.hpp"
+#include <cmath>
+
+Integrator::Integrator(){
+    this->primed = false;
+}
+
+void Integrator::reset(){
+    this->primed = false;
+}
+
+void Integrator::prime(ParticleSystem& particles, GravitySolver& solver){
+    if(!this->primed){
+        solver.calculateAccelerations(particles);
+        this->primed = true;
+    }
+}
+
+void Integrator::kick(ParticleSystem& particles, float dt){
+    float* vx = particles.vx.data();
+    float* vy = particles.vy.data();
+    const float* ax = particles.ax.data();
+    const float* ay = particles.ay.data();
+    for(size_t i = 0; i < particles.size(); i++){
+        vx[i] += ax[i] * dt;
+        vy[i] += ay[i] * dt;
+    }
+}
+
+void Integrator::drift(ParticleSystem& particles, float dt){
+    float* x = particles.x.data();
+    float* y = particles.y.data();
+    const float* vx = particles.vx.data();
+    const float* vy = particles.vy.data();
+    for(size_t i = 0; i < particles.size(); i++){
+        x[i] += vx[i] * dt;
+        y[i] += vy[i] * dt;
+    }
+}
+
+void EulerIntegrator::step(ParticleSystem& particles, GravitySolver& solver, float dt){
+    solver.calculateAccelerations(particles);
+    kick(particles, dt);
+    drift(particles, dt);
+    this->primed = false; //Accelerations are for the old positions
+}
+
+const char* EulerIntegrator::getName() const{
+    return "Euler";
+}
+
+IntegratorType EulerIntegrator::getType() const{
+    return IntegratorType::Euler;
+}
+
+void LeapfrogIntegrator::step(ParticleSystem& particles, GravitySolver& solver, float dt){
+    prime(particles, solver);
+    kick(particles, dt / 2);
+    drift(particles, dt);
+    solver.calculateAccelerations(particles);
+    kick(particles, dt / 2);
+}
+
+const char* LeapfrogIntegrator::getName() const{
+    return "Leapfrog";
+}
+
+IntegratorType LeapfrogIntegrator::getType() const{
+    return IntegratorType::Leapfrog;
+}
+
+void VelocityVerletIntegrator::step(ParticleSystem& particles, GravitySolver& solver, float dt){
+    prime(particles, solver);
+
+    //x += v dt + a dt^2 / 2, v += a dt / 2 with the old acceleration
+    float* x = particles.x.data();
+    float* y = particles.y.data();
+    float* vx = particles.vx.data();
+    float* vy = particles.vy.data();
+    const float* ax = particles.ax.data();
+    const float* ay = particles.ay.data();
+    for(size_t i = 0; i < particles.size(); i++){
+        x[i] += vx[i] * dt + ax[i] * (dt * dt / 2);
+        y[i] += vy[i] * dt + ay[i] * (dt * dt / 2);
+        vx[i] += ax[i] * (dt / 2);
+        vy[i] += ay[i] * (dt / 2);
+    }
+
+    //v += a dt / 2 with the new acceleration
+    solver.calculateAccelerations(particles);
+    kick(particles, dt / 2);
+}
+
+const char* VelocityVerletIntegrator::getName() const{
+    return "Velocity Verlet";
+}
+
+IntegratorType VelocityVerletIntegrator::getType() const{
+    return IntegratorType::VelocityVerlet;
+}
+
+void Yoshida4Integrator::step(ParticleSystem& particles, GravitySolver& solver, float dt){
+    //Leapfrog substeps of w1, w0, w1 with the touching half kicks merged
+    const double cubeRootTwo = std::cbrt(2.0);
+    const float w1 = 1.0 / (2.0 - cubeRootTwo);
+    const float w0 = -cubeRootTwo / (2.0 - cubeRootTwo);
+
+    prime(particles, solver);
+    kick(particles, w1 * dt / 2);
+    drift(particles, w1 * dt);
+    solver.calculateAccelerations(particles);
+    kick(particles, (w1 + w0) * dt / 2);
+    drift(particles, w0 * dt);
+    solver.calculateAccelerations(particles);
+    kick(particles, (w0 + w1) * dt / 2);
+    drift(particles, w1 * dt);
+    solver.calculateAccelerations(particles);
+    kick(particles, w1 * dt / 2);
+}
+
+const char* Yoshida4Integrator::getName() const{
+    return "Yoshida 4th order";
+}
+
+IntegratorType Yoshida4Integrator::getType() const{
+    return IntegratorType::Yoshida4;
+}
+
+std::unique_ptr<Integrator> createIntegrator(IntegratorType type){
+    switch(type){
+        case IntegratorType::Euler:
+            return std::unique_ptr<Integrator>(new EulerIntegrator());
+        case IntegratorType::VelocityVerlet:
+            return std::unique_ptr<Integrator>(new VelocityVerletIntegrator());
+        case IntegratorType::Yoshida4:
+            return std::unique_ptr<Integrator>(new Yoshida4Integrator());
+        default:
+            return std::unique_ptr<Integrator>(new LeapfrogIntegrator());
+    }
+}
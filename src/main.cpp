@@ -8,22 +8,57 @@
 #include <ios>
 #include <iostream>
 #include <cstring>
+#include <cstdlib>
 #include <chrono>
 #include <cmath>
 #include <fstream>
 #include <sstream>
 #include "shape.hpp"
-#include "planet.hpp"
+#include "particlesystem.hpp"
 #include "app.hpp"
+#include "checkpoint.hpp"
+#include "gravity.hpp"
+#include "instancedrenderer.hpp"
+#include "profiler.hpp"
+#include "scene.hpp"
+#include "simulation.hpp"
+#include "simulationthread.hpp"
 
-void framebuffer_size_callback(GLFWwindow* window, int width, int height);
-void processInput(GLFWwindow *window);
+enum class RenderMode {
+    Sdf, //One instanced quad per body, the disc shaded from its signed distance
+    Instanced, //One instanced draw of a 64 segment fan for every body
+    Shapes //A Circle per body, one draw call each
+};
 
-OpenGLApp app = OpenGLApp(nullptr);
+//Everything the GLFW callbacks act on, reached through the window user pointer
+typedef struct {
+    OpenGLApp* app;
+    SimulationThread* simulation; //The solver and simulation are only changed through its commands
+    RenderMode renderMode;
+}ViewerState;
 
+void framebuffer_size_callback(GLFWwindow* window, int width, int height);
+void processInput(GLFWwindow *window);
 void scrollCallback(GLFWwindow* window, double xoffset, double yoffset);
-int main()
+void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
+int runViewer(GLFWwindow* window, unsigned int threadCount, size_t bodies, const char* load);
+
+int main(int argc, char** argv)
 {
+    /* Command line */
+    unsigned int threadCount = 0; //0 uses every hardware thread
+    size_t bodies = 0; //0 loads the solar system
+    const char* load = nullptr; //Checkpoint to resume instead of a scene
+    for(int i = 1; i < argc; i++){
+        if(std::strcmp(argv[i], "--threads") == 0 && i + 1 < argc){
+            threadCount = std::atoi(argv[++i]);
+        }else if(std::strcmp(argv[i], "--bodies") == 0 && i + 1 < argc){
+            bodies = std::strtoul(argv[++i], nullptr, 10);
+        }else if(std::strcmp(argv[i], "--load") == 0 && i + 1 < argc){
+            load = argv[++i];
+        }
+    }
+
     /* GLFW */
     glfwInit();
     glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
@@ -44,7 +79,6 @@ int main()
     }
     glfwMakeContextCurrent(window);
     glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    glfwSetScrollCallback(window, scrollCallback);
 
     /* GLAD */
     if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
@@ -53,120 +87,202 @@ int main()
         return -1;
     }
 
+    //Every GL object is released inside, while the context still exists
+    int result = runViewer(window, threadCount, bodies, load);
+
+    // glfw: terminate, clearing all previously allocated GLFW resources.
+    // ------------------------------------------------------------------
+    glfwTerminate();
+    return result;
+}
+
+int runViewer(GLFWwindow* window, unsigned int threadCount, size_t bodies, const char* load){
     /* Create Application Object */
-    app = OpenGLApp(window);
+    OpenGLApp app(window);
 
     /* Shaders */
     if(app.parseShaders() == false){
-        exit(1);
+        return 1;
     }
 
     /* Scale Factor */
     app.setScaleFactor(1.0/SIM_SIZE);
     
+    /* Physics */
+    setProfilerThreadName("main");
+    ThreadPool pool(threadCount);
+    GravitySolver solver = GravitySolver(ForceSolver::DirectSum, BARNES_HUT_THETA, &pool);
+    Simulation simulation = Simulation(&solver);
+    std::cout << "Force kernel: " << solver.kernel.name << ", " << pool.getThreadCount() << " threads" << std::endl;
+
+    /* Planets */
+    if(load != nullptr){
+        if(!loadCheckpoint(load, simulation)){
+            return 1;
+        }
+    }else if(bodies > 0){
+        loadDisk(simulation.particles, bodies, 1);
+    }else{
+        loadSolarSystem(simulation.particles);
+    }
+
+    /* Simulation thread, from here on the simulation is only reached through it */
+    SimulationThread simulationThread(simulation);
+
+    /* Input */
+    ViewerState state = {&app, &simulationThread, RenderMode::Sdf};
+    glfwSetWindowUserPointer(window, &state);
+    glfwSetScrollCallback(window, scrollCallback);
+    glfwSetKeyCallback(window, keyCallback);
+
     /* Default settings */
     RGB backgroundColor = hex2rgb(0x000000);
 
-    /* Planets */
-    Planet planet1 = Planet("sun", 1000, {0, 0}, hex2rgb(0x90EE90));
-    Planet planet2 = Planet("earth", 5.97, {-350.0,200.0f}, hex2rgb(0xFFA500));
-    Planet planet3 = Planet("jupiter", 12, {650.0f,350.0f}, hex2rgb(0xFFC0CB));
-    Planet planet4 = Planet("moon", 1, {-350.0f,210.0f}, hex2rgb(0xFF0000));
-    planet2.velocity = {0.05f, 0.07f};
-    planet3.velocity = {0.0f, -0.05f};
-    planet4.velocity = {0.048f, 0.07f};
-    std::vector<Planet> planets;
+    /* Renderer */
+    //The SDF circles fade their edges, everything else is drawn opaque
+    glEnable(GL_BLEND);
+    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+    SdfCircleRenderer sdfRenderer(app.getSdfShaderProgram(), app.getGLState());
+    sdfRenderer.instances.reserve(simulation.particles.size());
+    InstancedCircleRenderer circleRenderer(app.getInstancedShaderProgram(), app.getGLState());
+    circleRenderer.instances.reserve(simulation.particles.size());
+    //Shapes mode circles by body id, created once. A change in level of detail only points the circle at
+    //another of the unit circles the app built at startup
     std::vector<Circle*> circles;
-    planets.push_back(planet1);
-    planets.push_back(planet2);
-    planets.push_back(planet3);
-    planets.push_back(planet4);
+    std::vector<unsigned int> visible; //Snapshot indices of the bodies in view, refilled every frame
 
     /* Frame timers */
-    std::chrono::time_point<std::chrono::high_resolution_clock> frameEnd, animationStart;
-    animationStart = std::chrono::high_resolution_clock::now();
-    frameEnd = std::chrono::high_resolution_clock::now();
+    std::chrono::time_point<std::chrono::high_resolution_clock> frameStart, titleStart;
+    titleStart = std::chrono::high_resolution_clock::now();
+    unsigned int titleFrames = 0;
 
+    simulationThread.start();
 
     /* Render loop */
     while (!glfwWindowShouldClose(window))
     {
-        /* Calculate frame time */
-        double dt = std::chrono::duration<double>(std::chrono::high_resolution_clock::now() - frameEnd).count();
-        dt *= 10000000; //Animation step speed
-
-        /* Apply forces */
-        //This loop makes sure planets are compared once
-        for(int i = 0; i < planets.size(); i++){
-            //First planet
-            Planet *p1 = &planets[i];
-            for(int j = i+1; j < planets.size(); j++){
-                //Second planet
-                Planet *p2 = &planets[j];
-                //Gather forces
-                Vector2D force1 = p1->calculateGravityForce(*p2);
-                Vector2D force2 = p2->calculateGravityForce(*p1);
-
-                //Calculate acceleration
-                //TODO: Calculate position and acceleration in planet class function
-                Vector2D acceleration1 = force1 * (1/p1->mass); 
-                Vector2D acceleration2 = force2 * (1/p2->mass); 
-
-                //Calculate velocity
-                p1->velocity = p1->velocity + acceleration1 * dt;
-                p2->velocity = p2->velocity + acceleration2 * dt;
-                planets[0].velocity = {0,0}; //Hard coded a 'sun' to not move for now, animation looks better
-
-                //Calculate position
-                p1->position = p1->position + p1->velocity * dt;
-                p2->position = p2->position + p2->velocity * dt;
-
-                //Move planets
-                //Probably should just be a wrapper around circle->move i.e: planet->move will call circle->move
-                planets[i].circle->move(p1->velocity.x * app.getScaleFactor() * dt, p1->velocity.y*app.getScaleFactor() * dt);
-                planets[j].circle->move(p2->velocity.x * app.getScaleFactor() * dt, p2->velocity.y*app.getScaleFactor() * dt);
-            }
-        } 
+        PROFILE_ZONE("frame");
+
+        frameStart = std::chrono::high_resolution_clock::now();
+
+        /* Newest state the simulation thread finished, never waits for it */
+        const SimulationSnapshot& snapshot = simulationThread.acquire();
+
+        /* Frame statistics, GL calls are those of the previous frame */
+        GLStateCache& glState = app.getGLState();
+        glState.beginFrame();
+        titleFrames++;
+        double titleSeconds = std::chrono::duration<double>(frameStart - titleStart).count();
+        if(titleSeconds >= 1.0){
+            std::ostringstream title;
+            title << "Planet Simulation - " << (int)(titleFrames / titleSeconds) << " FPS, "
+                  << (int)snapshot.measuredStepsPerSecond << " steps/s, "
+                  << glState.getLastFrameIssuedCalls() << " GL binds (" << glState.getLastFrameSkippedCalls() << " skipped)";
+            glfwSetWindowTitle(window, title.str().c_str());
+            titleStart = frameStart;
+            titleFrames = 0;
+        }
 
         /* User Input */
-        processInput(window);
+        {
+            PROFILE_ZONE("input");
+            processInput(window);
+        }
 
         /* Render */
 
         //Clear screen
-        glClearColor(backgroundColor.r, backgroundColor.g, backgroundColor.b, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT);
+        {
+            PROFILE_ZONE("clear");
+            glClearColor(backgroundColor.r, backgroundColor.g, backgroundColor.b, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+
+        //Add planets, interpolated between the snapshot's last two steps by the time since it was published
+        {
+            PROFILE_ZONE("render");
+            double shownSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - snapshot.published).count();
+            float alpha = std::fmin(snapshot.alpha + shownSeconds * snapshot.stepsPerSecond, 1.0);
+            float scale = app.getScaleFactor();
+            glm::vec2 pixelSize = app.getPixelSize();
+            float pixelsPerUnit = 1.0f / std::fmin(pixelSize.x, pixelSize.y);
+            //Only bodies whose bounds touch the view reach the renderers, the grid works in simulation units
+            glm::vec4 view = app.getViewRect();
+            snapshot.grid.query({view.x / scale, view.y / scale, view.z / scale, view.w / scale}, visible);
+            circleRenderer.clear();
+            sdfRenderer.clear();
+            if(state.renderMode == RenderMode::Shapes){
+                Shape::setCamera(app.getShaderProgram(), app.getGLState(), app.getCamera());
+            }
+            for(unsigned int i: visible){
+                float x = (snapshot.prevX[i] + (snapshot.x[i] - snapshot.prevX[i]) * alpha) * scale;
+                float y = (snapshot.prevY[i] + (snapshot.y[i] - snapshot.prevY[i]) * alpha) * scale;
+                float radius = bodyRadius(snapshot.mass[i]) * scale;
+                if(state.renderMode == RenderMode::Sdf){
+                    sdfRenderer.add(x, y, radius, snapshot.colors[i]);
+                    continue;
+                }
+                if(state.renderMode == RenderMode::Instanced){
+                    circleRenderer.add(x, y, radius, snapshot.colors[i]);
+                    continue;
+                }
 
-        //Add planets
-        for(Planet planet: planets){
-            //Probably should just be a wrapper around circle->render i.e: planet->render will call circle->render
-            planet.circle->render(app.getCamera());
+                //Unit circles placed and sized by their transform every frame
+                unsigned int id = snapshot.ids[i];
+                if(id >= circles.size()){
+                    circles.resize(id + 1, nullptr);
+                }
+                Circle*& circle = circles[id];
+                unsigned int segments = circleLodSegments(circleLod(radius * pixelsPerUnit));
+                if(circle == nullptr){
+                    circle = new Circle(app.getShaderProgram(), app.getMeshCache(), {0.0f, 0.0f}, snapshot.colors[i], radius, segments);
+                }
+                circle->setSegments(segments);
+                circle->setPosition(x, y);
+                circle->setScale(radius);
+                circle->render();
+            }
+            circleRenderer.render(app.getCamera(), pixelSize);
+            sdfRenderer.render(app.getCamera(), pixelSize);
         }
 
         // glfw: swap buffers and poll IO events (keys pressed/released, mouse moved etc.)
         // -------------------------------------------------------------------------------
-        glfwSwapBuffers(window);
-        glfwPollEvents();
-
-        //End of frame
-        frameEnd = std::chrono::high_resolution_clock::now();
+        {
+            PROFILE_ZONE("glfwSwapBuffers");
+            glfwSwapBuffers(window);
+        }
+        {
+            PROFILE_ZONE("glfwPollEvents");
+            glfwPollEvents();
+        }
    }
 
+    simulationThread.stop();
+
     // optional: de-allocate all resources once they've outlived their purpose:
     // ------------------------------------------------------------------------
-    //glDeleteBuffers(1, &EBO);
-    glDeleteProgram(app.getShaderProgram());
+    for(Circle* circle: circles){
+        delete circle;
+    }
+    app.getGLState().deleteProgram(app.getShaderProgram().id);
+    app.getGLState().deleteProgram(app.getInstancedShaderProgram().id);
+    app.getGLState().deleteProgram(app.getSdfShaderProgram().id);
 
-    // glfw: terminate, clearing all previously allocated GLFW resources.
-    // ------------------------------------------------------------------
-    glfwTerminate();
+    //The callbacks must not reach the state once it goes out of scope
+    glfwSetWindowUserPointer(window, nullptr);
     return 0;
 }
 
+static ViewerState* getViewerState(GLFWwindow* window){
+    return static_cast<ViewerState*>(glfwGetWindowUserPointer(window));
+}
+
 // process all input: query GLFW whether relevant keys are pressed/released this frame and react accordingly
 // ---------------------------------------------------------------------------------------------------------
 void processInput(GLFWwindow *window)
 {
+    OpenGLApp& app = *getViewerState(window)->app;
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS)
         glfwSetWindowShouldClose(window, true);
     if(glfwGetKey(window, GLFW_KEY_W) == GLFW_PRESS){
@@ -184,6 +300,11 @@ void processInput(GLFWwindow *window)
 }
 
 void scrollCallback(GLFWwindow* window, double xoffset, double yoffset){
+    ViewerState* state = getViewerState(window);
+    if(state == nullptr){
+        return;
+    }
+    OpenGLApp& app = *state->app;
     float zoomSensitivity = 0.1f; // Increase sensitivity for faster zoom changes
     
     if (yoffset > 0) {
@@ -193,6 +314,94 @@ void scrollCallback(GLFWwindow* window, double xoffset, double yoffset){
     }
 }
 
+void keyCallback(GLFWwindow* window, int key, int scancode, int action, int mods){
+    ViewerState* state = getViewerState(window);
+    if(action != GLFW_PRESS || state == nullptr){
+        return;
+    }
+    RenderMode& renderMode = state->renderMode;
+    SimulationThread& simulationThread = *state->simulation;
+
+    //R cycles SDF quads, instanced fans and per shape rendering
+    if(key == GLFW_KEY_R){
+        renderMode = (RenderMode)(((int)renderMode + 1) % 3);
+        const char* names[] = {"SDF quads", "instanced", "shapes"};
+        std::cout << "Render mode: " << names[(int)renderMode] << std::endl;
+        return;
+    }
+
+    //T writes the recorded timing zones. It runs between steps while this thread waits, so no thread is recording
+    if(key == GLFW_KEY_T){
+        simulationThread.call([](Simulation&){
+            if(writeChromeTrace("trace.json")){
+                std::cout << "Wrote trace.json" << std::endl;
+            }else{
+                std::cout << "Unable to write trace.json, is the profiler enabled (-DENABLE_PROFILER=ON)?" << std::endl;
+            }
+        });
+        return;
+    }
+
+    //F5 saves a checkpoint, between steps so the arrays are consistent
+    if(key == GLFW_KEY_F5){
+        simulationThread.post([](Simulation& simulation){
+            if(saveCheckpoint(simulation, "checkpoint.bin")){
+                std::cout << "Wrote checkpoint.bin at step " << simulation.steps << std::endl;
+            }
+        });
+        return;
+    }
+
+    //Everything else changes the simulation, on its thread between steps
+
+    //P switches between the hard cutoff and Plummer softening
+    if(key == GLFW_KEY_P){
+        simulationThread.post([](Simulation& simulation){
+            GravitySolver& solver = *simulation.solver;
+            solver.setForceLaw(solver.getForceLaw() == ForceLaw::Plummer ? ForceLaw::NewtonCutoff : ForceLaw::Plummer);
+            //Accelerations from the old law are stale
+            simulation.integrator->reset();
+            std::cout << "Force law: " << forceLawName(solver.getForceLaw()) << std::endl;
+        });
+        return;
+    }
+
+    //M toggles merging of touching bodies
+    if(key == GLFW_KEY_M){
+        simulationThread.post([](Simulation& simulation){
+            simulation.mergeCollisions = !simulation.mergeCollisions;
+            std::cout << "Merging: " << (simulation.mergeCollisions ? "on" : "off") << ", " << simulation.merges << " bodies merged so far" << std::endl;
+        });
+        return;
+    }
+
+    //I cycles integrators
+    if(key == GLFW_KEY_I){
+        simulationThread.post([](Simulation& simulation){
+            IntegratorType next = (IntegratorType)(((int)simulation.integrator->getType() + 1) % 4);
+            simulation.setIntegrator(next);
+            std::cout << "Integrator: " << simulation.integrator->getName() << std::endl;
+        });
+        return;
+    }
+
+    //B cycles force solvers, [ and ] tune the Barnes-Hut and multipole opening angle
+    if(key != GLFW_KEY_B && key != GLFW_KEY_LEFT_BRACKET && key != GLFW_KEY_RIGHT_BRACKET){
+        return;
+    }
+    simulationThread.post([key](Simulation& simulation){
+        GravitySolver& solver = *simulation.solver;
+        if(key == GLFW_KEY_B){
+            solver.solver = (ForceSolver)(((int)solver.solver + 1) % 4);
+        }else if(key == GLFW_KEY_LEFT_BRACKET){
+            solver.theta = std::fmax(solver.theta - 0.1f, 0.0f);
+        }else{
+            solver.theta = std::fmin(solver.theta + 0.1f, BARNES_HUT_MAX_THETA);
+        }
+        std::cout << "Force solver: " << solver.getName() << " (theta " << solver.theta << ")" << std::endl;
+    });
+}
+
 // glfw: whenever the window size changed (by OS or user resize) this callback function executes
 // ---------------------------------------------------------------------------------------------
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
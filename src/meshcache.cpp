@@ -0,0 +1,74 @@
+#include "meshcache.hpp"
+
+MeshCache::MeshCache(GLStateCache& state){
+    this->state = &state;
+}
+
+MeshCache::~MeshCache(){
+    for(auto& entry: this->meshes){
+        destroy(entry.second);
+    }
+}
+
+const Mesh* MeshCache::acquire(MeshType type, unsigned int parameter, const ShaderProgram& shader,
+                               const std::function<void(std::vector<float>&, std::vector<unsigned int>&)>& build){
+    Key key(shader.id, (int)type, parameter);
+    auto found = this->meshes.find(key);
+    if(found != this->meshes.end()){
+        found->second.references++;
+        return &found->second;
+    }
+
+    //Built, uploaded and freed here, the cache keeps only the buffers
+    std::vector<float> vertices;
+    std::vector<unsigned int> indices;
+    build(vertices, indices);
+
+    Mesh mesh;
+    mesh.indexCount = indices.size();
+    mesh.references = 1;
+    mesh.program = shader.id;
+    mesh.type = type;
+    mesh.parameter = parameter;
+
+    //The VAO is bound first so it records the element buffer as well
+    glGenVertexArrays(1, &mesh.vao);
+    this->state->bindVertexArray(mesh.vao);
+    glGenBuffers(1, &mesh.vbo);
+    this->state->bindBuffer(GL_ARRAY_BUFFER, mesh.vbo);
+    glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+    glGenBuffers(1, &mesh.ebo);
+    this->state->bindBuffer(GL_ELEMENT_ARRAY_BUFFER, mesh.ebo);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), indices.data(), GL_STATIC_DRAW);
+
+    int positionLocation = shader.getAttributeLocation("aPos");
+    glVertexAttribPointer(positionLocation, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+    glEnableVertexAttribArray(positionLocation);
+
+    return &this->meshes.emplace(key, mesh).first->second;
+}
+
+void MeshCache::release(const Mesh* mesh){
+    auto entry = this->meshes.find(Key(mesh->program, (int)mesh->type, mesh->parameter));
+    if(entry == this->meshes.end() || &entry->second != mesh){
+        return;
+    }
+    if(--entry->second.references == 0){
+        destroy(entry->second);
+        this->meshes.erase(entry);
+    }
+}
+
+GLStateCache& MeshCache::getState(){
+    return *this->state;
+}
+
+size_t MeshCache::size() const{
+    return this->meshes.size();
+}
+
+void MeshCache::destroy(Mesh& mesh){
+    this->state->deleteVertexArray(mesh.vao);
+    this->state->deleteBuffer(mesh.vbo);
+    this->state->deleteBuffer(mesh.ebo);
+}
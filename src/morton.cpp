@@ -0,0 +1,86 @@
+#include "morton.hpp"
+#include <cmath>
+#include <utility>
+#include "profiler.hpp"
+
+void MortonSorter::gather(std::vector<float>& values){
+    this->floatScratch.resize(values.size());
+    for(size_t i = 0; i < values.size(); i++){
+        this->floatScratch[i] = values[this->order[i]];
+    }
+    values.swap(this->floatScratch);
+}
+
+void MortonSorter::sort(ParticleSystem& particles){
+    PROFILE_ZONE("MortonSorter::sort");
+    size_t count = particles.size();
+    if(count < 2){
+        return;
+    }
+
+    float minX = particles.x[0], maxX = minX;
+    float minY = particles.y[0], maxY = minY;
+    for(size_t i = 1; i < count; i++){
+        minX = std::fmin(minX, particles.x[i]);
+        maxX = std::fmax(maxX, particles.x[i]);
+        minY = std::fmin(minY, particles.y[i]);
+        maxY = std::fmax(maxY, particles.y[i]);
+    }
+    //Square box so both axes are quantized alike
+    float scale = (float)((1 << MORTON_BITS) - 1) / std::fmax(std::fmax(maxX - minX, maxY - minY), 1e-6f);
+
+    this->codes.resize(count);
+    this->order.resize(count);
+    for(size_t i = 0; i < count; i++){
+        uint32_t cellX = (uint32_t)((particles.x[i] - minX) * scale);
+        uint32_t cellY = (uint32_t)((particles.y[i] - minY) * scale);
+        this->codes[i] = mortonCode(cellX, cellY);
+        this->order[i] = i;
+    }
+
+    //Least significant digit first, every pass is a stable counting sort
+    const unsigned int radix = 1 << MORTON_RADIX_BITS;
+    this->codeScratch.resize(count);
+    this->orderScratch.resize(count);
+    for(unsigned int shift = 0; shift < 2 * MORTON_BITS; shift += MORTON_RADIX_BITS){
+        size_t start[radix] = {};
+        for(size_t i = 0; i < count; i++){
+            start[(this->codes[i] >> shift) & (radix - 1)]++;
+        }
+        size_t sum = 0;
+        for(unsigned int d = 0; d < radix; d++){
+            size_t digitCount = start[d];
+            start[d] = sum;
+            sum += digitCount;
+        }
+        for(size_t i = 0; i < count; i++){
+            size_t target = start[(this->codes[i] >> shift) & (radix - 1)]++;
+            this->codeScratch[target] = this->codes[i];
+            this->orderScratch[target] = this->order[i];
+        }
+        this->codes.swap(this->codeScratch);
+        this->order.swap(this->orderScratch);
+    }
+
+    gather(particles.x);
+    gather(particles.y);
+    gather(particles.vx);
+    gather(particles.vy);
+    gather(particles.ax);
+    gather(particles.ay);
+    gather(particles.mass);
+    gather(particles.prevX);
+    gather(particles.prevY);
+
+    this->idScratch.resize(count);
+    this->planetScratch.clear();
+    for(size_t i = 0; i < count; i++){
+        this->idScratch[i] = particles.ids[this->order[i]];
+        this->planetScratch.push_back(std::move(particles.planets[this->order[i]]));
+    }
+    particles.ids.swap(this->idScratch);
+    particles.planets.swap(this->planetScratch);
+    for(size_t i = 0; i < count; i++){
+        particles.slots[particles.ids[i]] = i;
+    }
+}
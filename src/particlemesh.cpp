@@ -0,0 +1,187 @@
+#include "particlemesh.hpp"
+#include <algorithm>
+#include <cmath>
+#include "gravity.hpp"
+#include "planet.hpp"
+#include "profiler.hpp"
+
+#define PM_BLOCK_ROWS 16 //Grid rows per pool block
+#define PM_BLOCK_BODIES 4096 //Bodies per pool block when interpolating
+#define PM_DEPOSIT_BODIES 32768 //Bodies per deposition block, each one fills a grid of its own
+
+ParticleMesh::ParticleMesh(unsigned int gridSize) : fft(2 * gridSize){
+    this->gridSize = gridSize;
+    this->halfSize = 0.0f;
+    this->law = ForceLaw::NewtonCutoff;
+    this->params = {0.0f, 0.0f, 0.0f};
+}
+
+float ParticleMesh::getCellSize() const{
+    return 2 * this->halfSize / this->gridSize;
+}
+
+void ParticleMesh::buildGreens(ThreadPool* pool){
+    unsigned int size = 2 * this->gridSize;
+    float cellSize = getCellSize();
+    this->greens.assign((size_t)size * size, Complex(0.0f, 0.0f));
+    for(unsigned int y = 0; y < size; y++){
+        //Offsets past half the padded grid wrap around to negative ones
+        float dy = (y <= this->gridSize ? y : size - y) * cellSize;
+        for(unsigned int x = 0; x < size; x++){
+            float dx = (x <= this->gridSize ? x : size - x) * cellSize;
+            this->greens[(size_t)y * size + x] = Complex(forcePotential(this->law, this->params, dx * dx + dy * dy), 0.0f);
+        }
+    }
+    this->fft.forward(this->greens, size, pool);
+}
+
+void ParticleMesh::deposit(const ParticleSystem& particles, ThreadPool* pool){
+    PROFILE_ZONE("ParticleMesh::deposit");
+    unsigned int n = this->gridSize;
+    float cellSize = getCellSize();
+    size_t count = particles.size();
+
+    //A grid per fixed size block of bodies, summed in block order: blocks and sums only depend on the
+    //body count, so the result does not depend on the threads
+    unsigned int blocks = std::max<size_t>((count + PM_DEPOSIT_BODIES - 1) / PM_DEPOSIT_BODIES, 1);
+    this->blockMass.resize(blocks);
+    size_t chunk = PM_DEPOSIT_BODIES;
+    runBlocks(pool, blocks, [&](unsigned int block, unsigned int){
+        std::vector<float>& mass = this->blockMass[block];
+        mass.assign((size_t)n * n, 0.0f);
+        size_t end = std::min(count, (block + 1) * chunk);
+        for(size_t i = block * chunk; i < end; i++){
+            //Cloud-in-cell, the body's mass is shared by the four nearest cell centers
+            float u = (particles.x[i] + this->halfSize) / cellSize - 0.5f;
+            float v = (particles.y[i] + this->halfSize) / cellSize - 0.5f;
+            int cellX = (int)std::floor(u);
+            int cellY = (int)std::floor(v);
+            if(cellX < 0 || cellY < 0 || cellX + 1 >= (int)n || cellY + 1 >= (int)n){
+                continue;
+            }
+            float fx = u - cellX;
+            float fy = v - cellY;
+            float m = particles.mass[i];
+            float* row = &mass[(size_t)cellY * n + cellX];
+            row[0] += m * (1 - fx) * (1 - fy);
+            row[1] += m * fx * (1 - fy);
+            row[n] += m * (1 - fx) * fy;
+            row[n + 1] += m * fx * fy;
+        }
+    });
+
+    //Sum into the top left quarter of the padded grid, everything else is the zero padding
+    unsigned int size = 2 * n;
+    this->padded.resize((size_t)size * size);
+    runBlocks(pool, (size + PM_BLOCK_ROWS - 1) / PM_BLOCK_ROWS, [&](unsigned int block, unsigned int){
+        unsigned int end = std::min(size, (block + 1) * PM_BLOCK_ROWS);
+        for(unsigned int y = block * PM_BLOCK_ROWS; y < end; y++){
+            Complex* row = &this->padded[(size_t)y * size];
+            std::fill(row, row + size, Complex(0.0f, 0.0f));
+            if(y >= n){
+                continue;
+            }
+            for(unsigned int x = 0; x < n; x++){
+                float sum = 0.0f;
+                for(unsigned int b = 0; b < blocks; b++){
+                    sum += this->blockMass[b][(size_t)y * n + x];
+                }
+                row[x] = Complex(sum, 0.0f);
+            }
+        }
+    });
+}
+
+void ParticleMesh::interpolate(ParticleSystem& particles, ThreadPool* pool){
+    PROFILE_ZONE("ParticleMesh::interpolate");
+    int n = this->gridSize;
+    float cellSize = getCellSize();
+    size_t count = particles.size();
+    const float* potential = this->potential.data();
+
+    //Acceleration at a cell center, -grad of the potential by central differences, one sided at the edges
+    auto cellAcceleration = [&](int x, int y, float& ax, float& ay){
+        int left = std::max(x - 1, 0), right = std::min(x + 1, n - 1);
+        int down = std::max(y - 1, 0), up = std::min(y + 1, n - 1);
+        ax = -(potential[(size_t)y * n + right] - potential[(size_t)y * n + left]) / ((right - left) * cellSize);
+        ay = -(potential[(size_t)up * n + x] - potential[(size_t)down * n + x]) / ((up - down) * cellSize);
+    };
+
+    unsigned int blocks = (count + PM_BLOCK_BODIES - 1) / PM_BLOCK_BODIES;
+    runBlocks(pool, blocks, [&](unsigned int block, unsigned int){
+        size_t end = std::min(count, (size_t)(block + 1) * PM_BLOCK_BODIES);
+        for(size_t i = (size_t)block * PM_BLOCK_BODIES; i < end; i++){
+            float u = (particles.x[i] + this->halfSize) / cellSize - 0.5f;
+            float v = (particles.y[i] + this->halfSize) / cellSize - 0.5f;
+            int cellX = (int)std::floor(u);
+            int cellY = (int)std::floor(v);
+            particles.ax[i] = 0.0f;
+            particles.ay[i] = 0.0f;
+            if(cellX < 0 || cellY < 0 || cellX + 1 >= n || cellY + 1 >= n){
+                continue;
+            }
+
+            //Same weights as the deposit so a body does not push itself
+            float fx = u - cellX;
+            float fy = v - cellY;
+            float weights[4] = {(1 - fx) * (1 - fy), fx * (1 - fy), (1 - fx) * fy, fx * fy};
+            float ax = 0.0f, ay = 0.0f;
+            for(int corner = 0; corner < 4; corner++){
+                float cellAx, cellAy;
+                cellAcceleration(cellX + (corner & 1), cellY + (corner >> 1), cellAx, cellAy);
+                ax += weights[corner] * cellAx;
+                ay += weights[corner] * cellAy;
+            }
+            particles.ax[i] = ax;
+            particles.ay[i] = ay;
+        }
+    });
+}
+
+void ParticleMesh::calculateAccelerations(ParticleSystem& particles, ForceLaw law, const ForceParams& params, ThreadPool* pool){
+    //Smallest mesh that keeps every body two cells inside the edge
+    float extent = 0.0f;
+    for(size_t i = 0; i < particles.size(); i++){
+        extent = std::fmax(extent, std::fmax(std::fabs(particles.x[i]), std::fabs(particles.y[i])));
+    }
+    float halfSize = SIM_SIZE;
+    for(int doubling = 0; doubling < PM_MAX_DOUBLINGS && extent > halfSize * (1 - 4.0f / this->gridSize); doubling++){
+        halfSize *= 2;
+    }
+    bool lawChanged = law != this->law || params.g != this->params.g || params.minDistance != this->params.minDistance
+                      || params.softeningSquared != this->params.softeningSquared;
+    if(halfSize != this->halfSize || lawChanged){
+        this->halfSize = halfSize;
+        this->law = law;
+        this->params = params;
+        buildGreens(pool);
+    }
+
+    deposit(particles, pool);
+
+    //Potential = mass (*) Green's function, a product in frequency space
+    {
+        PROFILE_ZONE("ParticleMesh::convolve");
+        unsigned int n = this->gridSize;
+        unsigned int size = 2 * n;
+        this->fft.forward(this->padded, n, pool);
+        runBlocks(pool, (size + PM_BLOCK_ROWS - 1) / PM_BLOCK_ROWS, [&](unsigned int block, unsigned int){
+            size_t begin = (size_t)block * PM_BLOCK_ROWS * size;
+            size_t end = std::min((size_t)size * size, begin + (size_t)PM_BLOCK_ROWS * size);
+            for(size_t i = begin; i < end; i++){
+                this->padded[i] = multiply(this->padded[i], this->greens[i]);
+            }
+        });
+        this->fft.inverse(this->padded, n, pool);
+
+        float scale = 1.0f / ((float)size * size);
+        this->potential.resize((size_t)n * n);
+        for(unsigned int y = 0; y < n; y++){
+            for(unsigned int x = 0; x < n; x++){
+                this->potential[(size_t)y * n + x] = this->padded[(size_t)y * size + x].real() * scale;
+            }
+        }
+    }
+
+    interpolate(particles, pool);
+}
@@ -0,0 +1,69 @@
+#include "particlesystem.hpp"
+#include <utility>
+
+size_t ParticleSystem::addBody(std::string name, float mass, Vector2D pos, Vector2D velocity, RGB color){
+    this->x.push_back(pos.x);
+    this->y.push_back(pos.y);
+    this->vx.push_back(velocity.x);
+    this->vy.push_back(velocity.y);
+    this->ax.push_back(0.0f);
+    this->ay.push_back(0.0f);
+    this->mass.push_back(mass);
+    this->prevX.push_back(pos.x);
+    this->prevY.push_back(pos.y);
+    this->planets.push_back(Planet(name, color));
+    this->ids.push_back(this->slots.size());
+    this->slots.push_back(this->x.size() - 1);
+    return this->x.size() - 1;
+}
+
+void ParticleSystem::removeBody(size_t i){
+    size_t last = this->x.size() - 1;
+    this->x[i] = this->x[last];
+    this->y[i] = this->y[last];
+    this->vx[i] = this->vx[last];
+    this->vy[i] = this->vy[last];
+    this->ax[i] = this->ax[last];
+    this->ay[i] = this->ay[last];
+    this->mass[i] = this->mass[last];
+    this->prevX[i] = this->prevX[last];
+    this->prevY[i] = this->prevY[last];
+    std::swap(this->planets[i], this->planets[last]);
+    unsigned int removedId = this->ids[i];
+    this->ids[i] = this->ids[last];
+    this->slots[this->ids[i]] = i;
+    this->slots[removedId] = -1;
+    this->x.pop_back();
+    this->y.pop_back();
+    this->vx.pop_back();
+    this->vy.pop_back();
+    this->ax.pop_back();
+    this->ay.pop_back();
+    this->mass.pop_back();
+    this->prevX.pop_back();
+    this->prevY.pop_back();
+    this->planets.pop_back();
+    this->ids.pop_back();
+}
+
+size_t ParticleSystem::size() const{
+    return this->x.size();
+}
+
+int ParticleSystem::indexOf(unsigned int id) const{
+    return id < this->slots.size() ? this->slots[id] : -1;
+}
+
+void ParticleSystem::reserve(size_t count){
+    this->x.reserve(count);
+    this->y.reserve(count);
+    this->vx.reserve(count);
+    this->vy.reserve(count);
+    this->ax.reserve(count);
+    this->ay.reserve(count);
+    this->mass.reserve(count);
+    this->prevX.reserve(count);
+    this->prevY.reserve(count);
+    this->planets.reserve(count);
+    this->ids.reserve(count);
+}
@@ -0,0 +1,132 @@
+#include "profiler.hpp"
+
+#ifdef ENABLE_PROFILER
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+typedef struct {
+    const char* name;
+    uint64_t start;
+    uint64_t end;
+}ProfileEvent;
+
+//Written only by its own thread, written counts every zone ever recorded
+typedef struct {
+    ProfileEvent events[PROFILER_RING_SIZE];
+    std::atomic<uint64_t> written;
+    unsigned int id;
+    std::string name;
+}ProfileRing;
+
+//Rings outlive their threads so zones of finished threads can still be exported
+static std::mutex ringMutex;
+static std::vector<std::unique_ptr<ProfileRing>> rings;
+static thread_local ProfileRing* threadRing = nullptr;
+
+//Ticks and wall clock at startup, the export converts ticks to microseconds against them
+static const uint64_t baseTicks = profilerTicks();
+static const std::chrono::steady_clock::time_point baseTime = std::chrono::steady_clock::now();
+
+uint64_t profilerClockFallback(){
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static ProfileRing* getThreadRing(){
+    if(threadRing == nullptr){
+        std::lock_guard<std::mutex> lock(ringMutex);
+        rings.push_back(std::unique_ptr<ProfileRing>(new ProfileRing()));
+        threadRing = rings.back().get();
+        threadRing->written = 0;
+        threadRing->id = rings.size() - 1;
+        threadRing->name = "thread " + std::to_string(threadRing->id);
+    }
+    return threadRing;
+}
+
+void recordProfileZone(const char* name, uint64_t start, uint64_t end){
+    ProfileRing* ring = getThreadRing();
+    uint64_t written = ring->written.load(std::memory_order_relaxed);
+    ProfileEvent& event = ring->events[written & (PROFILER_RING_SIZE - 1)];
+    event.name = name;
+    event.start = start;
+    event.end = end;
+    ring->written.store(written + 1, std::memory_order_release);
+}
+
+void setProfilerThreadName(const std::string& name){
+    ProfileRing* ring = getThreadRing();
+    std::lock_guard<std::mutex> lock(ringMutex);
+    ring->name = name;
+}
+
+//Zone names are literals from our own code, only quotes and backslashes need escaping
+static void writeJsonString(std::ofstream& file, const std::string& text){
+    file << '"';
+    for(char c: text){
+        if(c == '"' || c == '\\'){
+            file << '\\';
+        }
+        file << c;
+    }
+    file << '"';
+}
+
+bool writeChromeTrace(const std::string& path){
+    std::ofstream file(path);
+    if(!file.is_open()){
+        return false;
+    }
+
+    //Microseconds per tick measured over the whole run, exact for the nanosecond fallback
+    double elapsedMicroseconds = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - baseTime).count();
+    uint64_t elapsedTicks = profilerTicks() - baseTicks;
+#ifdef PROFILER_RDTSC
+    double microsecondsPerTick = elapsedTicks > 0 ? elapsedMicroseconds / elapsedTicks : 0.0;
+#else
+    (void)elapsedMicroseconds;
+    (void)elapsedTicks;
+    double microsecondsPerTick = 1e-3;
+#endif
+
+    std::lock_guard<std::mutex> lock(ringMutex);
+    file << std::fixed;
+    file.precision(3);
+    file << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    bool first = true;
+    for(const std::unique_ptr<ProfileRing>& ring: rings){
+        file << (first ? "\n" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << ring->id << ",\"args\":{\"name\":";
+        writeJsonString(file, ring->name);
+        file << "}}";
+        first = false;
+
+        uint64_t written = ring->written.load(std::memory_order_acquire);
+        uint64_t oldest = written > PROFILER_RING_SIZE ? written - PROFILER_RING_SIZE : 0;
+        for(uint64_t i = oldest; i < written; i++){
+            const ProfileEvent& event = ring->events[i & (PROFILER_RING_SIZE - 1)];
+            double start = (double)(int64_t)(event.start - baseTicks) * microsecondsPerTick;
+            double duration = (double)(event.end - event.start) * microsecondsPerTick;
+            file << ",\n{\"name\":";
+            writeJsonString(file, event.name);
+            file << ",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring->id << ",\"ts\":" << start << ",\"dur\":" << duration << "}";
+        }
+    }
+    file << "\n]}\n";
+    return file.good();
+}
+
+#else
+
+void setProfilerThreadName(const std::string&){
+}
+
+bool writeChromeTrace(const std::string&){
+    return false;
+}
+
+#endif
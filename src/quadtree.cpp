@@ -0,0 +1,161 @@
+#include "quadtree.hpp"
+#include <algorithm>
+
+QuadTree::QuadTree(unsigned int leafSize){
+    this->leafSize = leafSize;
+}
+
+void QuadTree::build(const ParticleSystem& particles){
+    size_t count = particles.size();
+    this->nodes.clear();
+    this->order.resize(count);
+    this->scratch.resize(count);
+    if(count == 0){
+        return;
+    }
+
+    //Bounding square of all bodies
+    float minX = particles.x[0], maxX = minX;
+    float minY = particles.y[0], maxY = minY;
+    for(size_t i = 0; i < count; i++){
+        this->order[i] = i;
+        minX = std::fmin(minX, particles.x[i]);
+        maxX = std::fmax(maxX, particles.x[i]);
+        minY = std::fmin(minY, particles.y[i]);
+        maxY = std::fmax(maxY, particles.y[i]);
+    }
+
+    QuadNode root;
+    root.centerX = (minX + maxX) / 2;
+    root.centerY = (minY + maxY) / 2;
+    root.halfSize = std::fmax(maxX - minX, maxY - minY) / 2 + 1.0f;
+    root.firstChild = -1;
+    root.begin = 0;
+    root.count = count;
+    this->nodes.push_back(root);
+    split(particles, 0, 0);
+}
+
+void QuadTree::split(const ParticleSystem& particles, int node, int depth){
+    int begin = this->nodes[node].begin;
+    int count = this->nodes[node].count;
+
+    if(count > (int)this->leafSize && depth < QUADTREE_MAX_DEPTH){
+        float cx = this->nodes[node].centerX;
+        float cy = this->nodes[node].centerY;
+        float half = this->nodes[node].halfSize / 2;
+
+        //Counting sort of the node's bodies by quadrant (bit 0: right, bit 1: top)
+        int quadrantCount[4] = {0, 0, 0, 0};
+        for(int i = begin; i < begin + count; i++){
+            int body = this->order[i];
+            quadrantCount[(particles.x[body] >= cx) | ((particles.y[body] >= cy) << 1)]++;
+        }
+        int quadrantStart[4];
+        quadrantStart[0] = begin;
+        for(int q = 1; q < 4; q++){
+            quadrantStart[q] = quadrantStart[q - 1] + quadrantCount[q - 1];
+        }
+        int next[4] = {quadrantStart[0], quadrantStart[1], quadrantStart[2], quadrantStart[3]};
+        for(int i = begin; i < begin + count; i++){
+            int body = this->order[i];
+            this->scratch[next[(particles.x[body] >= cx) | ((particles.y[body] >= cy) << 1)]++] = body;
+        }
+        std::copy(this->scratch.begin() + begin, this->scratch.begin() + begin + count, this->order.begin() + begin);
+
+        int firstChild = this->nodes.size();
+        this->nodes[node].firstChild = firstChild;
+        for(int q = 0; q < 4; q++){
+            QuadNode child;
+            child.centerX = cx + ((q & 1) ? half : -half);
+            child.centerY = cy + ((q & 2) ? half : -half);
+            child.halfSize = half;
+            child.firstChild = -1;
+            child.begin = quadrantStart[q];
+            child.count = quadrantCount[q];
+            this->nodes.push_back(child);
+        }
+        for(int q = 0; q < 4; q++){
+            split(particles, firstChild + q, depth + 1);
+        }
+
+        //Monopole from the children
+        float mass = 0, comX = 0, comY = 0;
+        for(int q = 0; q < 4; q++){
+            const QuadNode& child = this->nodes[firstChild + q];
+            mass += child.mass;
+            comX += child.comX * child.mass;
+            comY += child.comY * child.mass;
+        }
+        this->nodes[node].mass = mass;
+        this->nodes[node].comX = mass > 0 ? comX / mass : cx;
+        this->nodes[node].comY = mass > 0 ? comY / mass : cy;
+        return;
+    }
+
+    //Leaf, monopole straight from the bodies
+    float mass = 0, comX = 0, comY = 0;
+    for(int i = begin; i < begin + count; i++){
+        int body = this->order[i];
+        mass += particles.mass[body];
+        comX += particles.x[body] * particles.mass[body];
+        comY += particles.y[body] * particles.mass[body];
+    }
+    this->nodes[node].mass = mass;
+    this->nodes[node].comX = mass > 0 ? comX / mass : this->nodes[node].centerX;
+    this->nodes[node].comY = mass > 0 ? comY / mass : this->nodes[node].centerY;
+}
+
+template<class Law>
+Vector2D QuadTree::calculateAcceleration(const ParticleSystem& particles, int index, float theta, const ForceParams& params, std::vector<int>& stack) const{
+    float x = particles.x[index];
+    float y = particles.y[index];
+    float ax = 0.0f, ay = 0.0f;
+    if(this->nodes.empty()){
+        return {ax, ay};
+    }
+
+    stack.clear();
+    stack.push_back(0);
+    while(!stack.empty()){
+        const QuadNode& node = this->nodes[stack.back()];
+        stack.pop_back();
+        if(node.count == 0){
+            continue;
+        }
+
+        if(node.firstChild < 0){
+            //Leaf, sum its bodies directly
+            for(int i = node.begin; i < node.begin + node.count; i++){
+                int body = this->order[i];
+                if(body != index){
+                    float bodyX = particles.x[body] - x;
+                    float bodyY = particles.y[body] - y;
+                    float scale = Law::template scalar<ScalarOps>(params, bodyX * bodyX + bodyY * bodyY) * particles.mass[body];
+                    ax += bodyX * scale;
+                    ay += bodyY * scale;
+                }
+            }
+            continue;
+        }
+
+        //Opening criterion: node size / distance < theta treats the node as a single body
+        float dx = node.comX - x;
+        float dy = node.comY - y;
+        float size = 2 * node.halfSize;
+        float distanceSquared = dx * dx + dy * dy;
+        if(size * size < theta * theta * distanceSquared){
+            float scale = Law::template scalar<ScalarOps>(params, distanceSquared) * node.mass;
+            ax += dx * scale;
+            ay += dy * scale;
+            continue;
+        }
+        for(int q = 0; q < 4; q++){
+            stack.push_back(node.firstChild + q);
+        }
+    }
+    return {ax, ay};
+}
+
+template Vector2D QuadTree::calculateAcceleration<NewtonCutoff>(const ParticleSystem&, int, float, const ForceParams&, std::vector<int>&) const;
+template Vector2D QuadTree::calculateAcceleration<Plummer>(const ParticleSystem&, int, float, const ForceParams&, std::vector<int>&) const;
@@ -0,0 +1,53 @@
+#include "scene.hpp"
+#include <random>
+
+//Shifts every velocity so the total momentum is zero, otherwise the whole scene drifts off screen
+static void removeNetMomentum(ParticleSystem& particles, size_t first){
+    double momentumX = 0.0, momentumY = 0.0, totalMass = 0.0;
+    for(size_t i = first; i < particles.size(); i++){
+        momentumX += particles.mass[i] * particles.vx[i];
+        momentumY += particles.mass[i] * particles.vy[i];
+        totalMass += particles.mass[i];
+    }
+    for(size_t i = first; i < particles.size(); i++){
+        particles.vx[i] -= momentumX / totalMass;
+        particles.vy[i] -= momentumY / totalMass;
+    }
+}
+
+void loadSolarSystem(ParticleSystem& particles){
+    size_t first = particles.size();
+    particles.addBody("sun", 1000, {0, 0}, {0.0f, 0.0f}, hex2rgb(0x90EE90));
+    particles.addBody("earth", 5.97, {-350.0,200.0f}, {0.05f, 0.07f}, hex2rgb(0xFFA500));
+    particles.addBody("jupiter", 12, {650.0f,350.0f}, {0.0f, -0.05f}, hex2rgb(0xFFC0CB));
+    particles.addBody("moon", 1, {-350.0f,210.0f}, {0.048f, 0.07f}, hex2rgb(0xFF0000));
+    removeNetMomentum(particles, first);
+}
+
+void loadDisk(ParticleSystem& particles, size_t count, unsigned int seed){
+    const float sunMass = 1000.0f;
+    const float diskMass = 1000.0f;
+    const float innerRadius = 50.0f;
+    const float outerRadius = SIM_SIZE * 0.9f;
+
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<float> radiusDistribution(innerRadius, outerRadius);
+    std::uniform_real_distribution<float> angleDistribution(0.0f, 2 * M_PI);
+    const int colors[] = {0xFFA500, 0xFFC0CB, 0xFF0000, 0xADD8E6, 0xFFFFFF};
+
+    size_t first = particles.size();
+    particles.reserve(first + count + 1);
+    particles.addBody("sun", sunMass, {0, 0}, {0.0f, 0.0f}, hex2rgb(0x90EE90));
+    for(size_t i = 0; i < count; i++){
+        float radius = radiusDistribution(rng);
+        float angle = angleDistribution(rng);
+
+        //Circular speed around the sun and the part of the disk inside this orbit
+        float enclosedMass = sunMass + diskMass * (radius - innerRadius) / (outerRadius - innerRadius);
+        float speed = std::sqrt(G_CONST * enclosedMass / radius);
+        Vector2D pos = {radius * std::cos(angle), radius * std::sin(angle)};
+        Vector2D velocity = {-speed * std::sin(angle), speed * std::cos(angle)};
+        particles.addBody("body " + std::to_string(i), diskMass / count, pos, velocity, hex2rgb(colors[i % 5]));
+    }
+    removeNetMomentum(particles, first);
+}
@@ -0,0 +1,36 @@
+#include "shader.hpp"
+
+ShaderProgram::ShaderProgram(unsigned int id){
+    this->id = id;
+    if(id == 0){
+        return;
+    }
+
+    char name[256];
+    GLsizei length;
+    GLint size;
+    GLenum type;
+    int count = 0;
+    glGetProgramiv(id, GL_ACTIVE_UNIFORMS, &count);
+    for(int i = 0; i < count; i++){
+        glGetActiveUniform(id, i, sizeof(name), &length, &size, &type, name);
+        this->uniforms[name] = glGetUniformLocation(id, name);
+    }
+
+    count = 0;
+    glGetProgramiv(id, GL_ACTIVE_ATTRIBUTES, &count);
+    for(int i = 0; i < count; i++){
+        glGetActiveAttrib(id, i, sizeof(name), &length, &size, &type, name);
+        this->attributes[name] = glGetAttribLocation(id, name);
+    }
+}
+
+int ShaderProgram::getUniformLocation(const std::string& name) const{
+    std::unordered_map<std::string, int>::const_iterator it = this->uniforms.find(name);
+    return it == this->uniforms.end() ? -1 : it->second;
+}
+
+int ShaderProgram::getAttributeLocation(const std::string& name) const{
+    std::unordered_map<std::string, int>::const_iterator it = this->attributes.find(name);
+    return it == this->attributes.end() ? -1 : it->second;
+}
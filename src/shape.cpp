@@ -1,78 +1,73 @@
 #include "shape.hpp"
 
-Shape::Shape(unsigned int shader, std::vector<float> vertices, std::vector<unsigned int> indices, RGB color, int numElements){
-    this->shader = shader;
-    this->vertices = vertices;
-    this->createVBO();
+static std::function<void(std::vector<float>&, std::vector<unsigned int>&)> unitCircle(unsigned int numElements){
+    return [numElements](std::vector<float>& vertices, std::vector<unsigned int>& indices){
+        vertices = Circle::calculateVertices({0.0f, 0.0f}, 1.0f, numElements);
+        indices = Circle::calculateIndices(numElements);
+    };
+}
 
-    this->indices = indices;
-    this->createEBO();
+Shape::Shape(const ShaderProgram& shader, MeshCache& meshes, MeshType type, unsigned int parameter,
+             const std::function<void(std::vector<float>&, std::vector<unsigned int>&)>& build, RGB color, Pos pos, float size){
+    this->shader = &shader;
+    this->meshes = &meshes;
+    this->colorLocation = shader.getUniformLocation("aColor");
+    this->transformLocation = shader.getUniformLocation("transform");
 
     this->color = color;
 
-    this->numComponents = 3;
-    this->numElements = numElements;
-
-    this->createVAO(shader);
-
-    this->trans = glm::mat4(1.0f);
+    //Every shape of a kind shares one unit mesh, position and size only live in the transform
+    this->mesh = meshes.acquire(type, parameter, shader, build);
+    this->transform = {pos.x, pos.y, 0.0f, size};
 }
 
 Shape::~Shape(){
-    glDeleteVertexArrays(1, &this->vao);
-    glDeleteBuffers(1, &this->vbo);
-}
-
-void Shape::createVAO(unsigned int shader){
-        glGenVertexArrays(1, &this->vao);
-        glBindVertexArray(this->vao);
-        glVertexAttribPointer(0, this->numComponents , GL_FLOAT, GL_FALSE, this->numComponents * sizeof(float), (void*)0);
-        //TODO: Find shader attrib for vertex coords and change value, currently variable is hardcoded
-        glEnableVertexAttribArray(0);
-        glBindVertexArray(0);
+    this->meshes->release(this->mesh);
 }
 
-void Shape::createVBO(){
-    glGenBuffers(1, &this->vbo);
-    glBindBuffer(GL_ARRAY_BUFFER, this->vbo);
-    glBufferData(GL_ARRAY_BUFFER, vertices.size()*sizeof(float), this->vertices.data(), GL_STATIC_DRAW);
+void Shape::setCamera(const ShaderProgram& shader, GLStateCache& state, const glm::mat4& camera){
+    state.useProgram(shader.id);
+    glUniformMatrix4fv(shader.getUniformLocation("camera"), 1, GL_FALSE, glm::value_ptr(camera));
 }
 
-void Shape::createEBO(){
-    glGenBuffers(1, &this->ebo);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size()*sizeof(unsigned int), this->indices.data(), GL_STATIC_DRAW);
-}
-
-void Shape::render(const glm::mat4& mvMatrix){
-    glBindVertexArray(this->vao);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, this->ebo);
-
-    glUseProgram(this->shader);
-    int colorLocation = glGetUniformLocation(this->shader, "aColor"); 
-    glUniform4f(colorLocation, color.r, color.g, color.b, 1.0f);
+void Shape::render(){
+    //The VAO already references the buffers, nothing is unbound afterwards
+    GLStateCache& state = this->meshes->getState();
+    state.bindVertexArray(this->mesh->vao);
+    state.useProgram(this->shader->id);
+    glUniform4f(this->colorLocation, color.r, color.g, color.b, 1.0f);
 
-    glm::mat4 mvp = mvMatrix * this->trans;
+    //Rotation and scale folded into one column, the shader does the rest
+    float cosine = this->transform.rotation == 0.0f ? 1.0f : std::cos(this->transform.rotation);
+    float sine = this->transform.rotation == 0.0f ? 0.0f : std::sin(this->transform.rotation);
+    glUniform4f(this->transformLocation, this->transform.x, this->transform.y, this->transform.scale * cosine, this->transform.scale * sine);
 
-    int transformLocation = glGetUniformLocation(this->shader, "transform"); 
-    glUniformMatrix4fv(transformLocation, 1, GL_FALSE, glm::value_ptr(mvp));
+    glDrawElements(GL_TRIANGLES, this->mesh->indexCount, GL_UNSIGNED_INT, 0);
+}
 
-    glDrawElements(GL_TRIANGLES, this->indices.size(), GL_UNSIGNED_INT, 0);
+void Shape::move(float x, float y){
+    this->transform.x += x;
+    this->transform.y += y;
+}
 
-    glBindVertexArray(0);
-    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
-    glBindBuffer(GL_ARRAY_BUFFER, 0);
+void Shape::setPosition(float x, float y){
+    this->transform.x = x;
+    this->transform.y = y;
 }
 
-void Shape::move(float x, float y){
-    this->trans = glm::translate(this->trans, glm::vec3(x,y,0.0f));
+void Shape::setScale(float scale){
+    this->transform.scale = scale;
 }
 
-void Shape::reset(){
-    this->trans = glm::mat4(1.0f);
+void Shape::setRotation(float rotation){
+    this->transform.rotation = rotation;
 }
 
-Square::Square(unsigned int shader, Pos pos, RGB color, float sideLength) : Shape(shader, calculateVertices(pos,sideLength), calculateIndices(), color, 2) { }
+Square::Square(const ShaderProgram& shader, MeshCache& meshes, Pos pos, RGB color, float sideLength) : Shape(shader, meshes, MeshType::Square, 0, [](std::vector<float>& vertices, std::vector<unsigned int>& indices){
+    vertices = calculateVertices({0.0f, 0.0f}, 1.0f);
+    indices = calculateIndices();
+}, color, pos, sideLength) { }
+
 std::vector<float> Square::calculateVertices(Pos pos, float sideLength){
     return {
             (pos.x + (sideLength/2)), (pos.y + (sideLength/2)), 0.0f, //Top Right
@@ -86,7 +81,10 @@ std::vector<unsigned int> Square::calculateIndices(){
     return {0,1,3,1,2,3};
 }
 
-Triangle::Triangle(unsigned int shader, Pos pos, RGB color, float sideLength) : Shape(shader, calculateVertices(pos,sideLength), calculateIndices(), color, 2) { }
+Triangle::Triangle(const ShaderProgram& shader, MeshCache& meshes, Pos pos, RGB color, float sideLength) : Shape(shader, meshes, MeshType::Triangle, 0, [](std::vector<float>& vertices, std::vector<unsigned int>& indices){
+    vertices = calculateVertices({0.0f, 0.0f}, 1.0f);
+    indices = calculateIndices();
+}, color, pos, sideLength) { }
 
 std::vector<float> Triangle::calculateVertices(Pos pos, float sideLength){
     return {
@@ -100,31 +98,30 @@ std::vector<unsigned int> Triangle::calculateIndices(){
     return {0,2,1};
 }
 
-Circle::Circle(unsigned int shader, Pos pos, RGB color, float radius, unsigned int numElements) : Shape(shader, calculateVertices(pos,radius,  numElements), calculateIndices(numElements), color, numElements) { }
-std::vector<float> Circle::calculateVertices(Pos pos, float radius, unsigned int numElements){
-    std::vector<float> vertices;
-    float angleStep = 2 * PI / numElements; 
-    vertices.push_back(pos.x);
-    vertices.push_back(pos.y);
-    vertices.push_back(0.0f);
-    for(int i = 0; i < numElements; i++){
-        float angle =  i * angleStep;
-        vertices.push_back(pos.x + radius * cos(angle));
-        vertices.push_back(pos.y + radius * sin(angle));
-        vertices.push_back(0.0f);
-    }
-   return vertices; 
+Circle::Circle(const ShaderProgram& shader, MeshCache& meshes, Pos pos, RGB color, float radius, unsigned int numElements)
+    : Shape(shader, meshes, MeshType::Circle, numElements, unitCircle(numElements), color, pos, radius){
+    this->segments = numElements;
 }
 
-std::vector<unsigned int> Circle::calculateIndices(unsigned int numElements){
-    std::vector<unsigned int> indices;
-    for(int i = 0; i < numElements; i++){
-        indices.push_back(0);
-        indices.push_back(i + 1);
-        //indices[(i*VERTEX_COORD_TOTAL)+2] = i + 2;
-        indices.push_back((i + 1) % numElements + 1);
+void Circle::setSegments(unsigned int numElements){
+    if(numElements == this->segments){
+        return;
     }
-    return indices;
+    //The new mesh is taken before the old one is let go, so neither is rebuilt when this circle is the only user
+    const Mesh* mesh = acquireMesh(*this->shader, *this->meshes, numElements);
+    this->meshes->release(this->mesh);
+    this->mesh = mesh;
+    this->segments = numElements;
 }
 
+const Mesh* Circle::acquireMesh(const ShaderProgram& shader, MeshCache& meshes, unsigned int numElements){
+    return meshes.acquire(MeshType::Circle, numElements, shader, unitCircle(numElements));
+}
 
+std::vector<float> Circle::calculateVertices(Pos pos, float radius, unsigned int numElements){
+    return circleVertices(pos, radius, numElements);
+}
+
+std::vector<unsigned int> Circle::calculateIndices(unsigned int numElements){
+    return circleIndices(numElements);
+}
@@ -0,0 +1,66 @@
+#include "simulation.hpp"
+#include "profiler.hpp"
+
+Simulation::Simulation(GravitySolver* solver, IntegratorType integratorType){
+    this->solver = solver;
+    this->integrator = createIntegrator(integratorType);
+    this->stepSize = SIM_STEP;
+    this->stepsPerSecond = SIM_STEPS_PER_SECOND;
+    this->maxSubsteps = SIM_MAX_SUBSTEPS;
+    this->time = 0.0;
+    this->steps = 0;
+    this->mergeCollisions = true;
+    this->merges = 0;
+    this->sortInterval = SIM_SORT_INTERVAL;
+    this->accumulator = 0.0;
+}
+
+unsigned int Simulation::advance(double frameSeconds){
+    this->accumulator += frameSeconds * this->stepsPerSecond;
+
+    unsigned int substeps = 0;
+    while(this->accumulator >= 1.0 && substeps < this->maxSubsteps){
+        step();
+        this->accumulator -= 1.0;
+        substeps++;
+    }
+
+    //Too far behind, drop the backlog instead of trying to catch up next frame
+    if(this->accumulator >= 1.0){
+        this->accumulator = 0.0;
+    }
+    return substeps;
+}
+
+void Simulation::setIntegrator(IntegratorType type){
+    this->integrator = createIntegrator(type);
+}
+
+void Simulation::step(){
+    PROFILE_ZONE("Simulation::step");
+    //Bodies drift away from their neighbours in memory, put them back in space filling curve order
+    if(this->sortInterval > 0 && this->steps % this->sortInterval == 0){
+        this->sorter.sort(this->particles);
+    }
+
+    this->particles.prevX = this->particles.x;
+    this->particles.prevY = this->particles.y;
+
+    this->integrator->step(this->particles, *this->solver, this->stepSize);
+
+    if(this->mergeCollisions){
+        size_t removed = this->collisions.merge(this->particles);
+        if(removed > 0){
+            //The accelerations left for the next kick belong to bodies that no longer exist
+            this->integrator->reset();
+            this->merges += removed;
+        }
+    }
+
+    this->time += this->stepSize;
+    this->steps++;
+}
+
+float Simulation::getAlpha() const{
+    return this->accumulator;
+}
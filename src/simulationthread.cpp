@@ -0,0 +1,128 @@
+#include "simulationthread.hpp"
+#include <algorithm>
+#include <condition_variable>
+#include "profiler.hpp"
+
+SimulationThread::SimulationThread(Simulation& simulation) : simulation(simulation){
+    this->running = false;
+    this->measuredStepsPerSecond = 0.0;
+    //The reader has something to draw before the thread first publishes
+    publish();
+    this->snapshots.update();
+}
+
+SimulationThread::~SimulationThread(){
+    stop();
+}
+
+void SimulationThread::start(){
+    if(this->running){
+        return;
+    }
+    this->running = true;
+    this->thread = std::thread(&SimulationThread::run, this);
+}
+
+void SimulationThread::stop(){
+    if(!this->running){
+        return;
+    }
+    this->running = false;
+    this->thread.join();
+    //Commands posted after the last pass still run, on the caller now that the thread is gone
+    runCommands();
+}
+
+void SimulationThread::post(const std::function<void(Simulation&)>& command){
+    std::lock_guard<std::mutex> lock(this->commandMutex);
+    this->commands.push_back(command);
+}
+
+void SimulationThread::call(const std::function<void(Simulation&)>& command){
+    if(!this->running){
+        command(this->simulation);
+        return;
+    }
+    std::mutex mutex;
+    std::condition_variable finished;
+    bool done = false;
+    post([&](Simulation& simulation){
+        command(simulation);
+        std::lock_guard<std::mutex> lock(mutex);
+        done = true;
+        finished.notify_one();
+    });
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&]{ return done; });
+}
+
+const SimulationSnapshot& SimulationThread::acquire(){
+    this->snapshots.update();
+    return this->snapshots.readSlot();
+}
+
+void SimulationThread::runCommands(){
+    {
+        std::lock_guard<std::mutex> lock(this->commandMutex);
+        this->runningCommands.swap(this->commands);
+    }
+    for(const std::function<void(Simulation&)>& command: this->runningCommands){
+        command(this->simulation);
+    }
+    this->runningCommands.clear();
+}
+
+void SimulationThread::publish(){
+    PROFILE_ZONE("SimulationThread::publish");
+    const ParticleSystem& particles = this->simulation.particles;
+    SimulationSnapshot& snapshot = this->snapshots.writeSlot();
+    snapshot.x.assign(particles.x.begin(), particles.x.end());
+    snapshot.y.assign(particles.y.begin(), particles.y.end());
+    snapshot.prevX.assign(particles.prevX.begin(), particles.prevX.end());
+    snapshot.prevY.assign(particles.prevY.begin(), particles.prevY.end());
+    snapshot.mass.assign(particles.mass.begin(), particles.mass.end());
+    snapshot.ids.assign(particles.ids.begin(), particles.ids.end());
+    snapshot.colors.resize(particles.size());
+    for(size_t i = 0; i < particles.size(); i++){
+        snapshot.colors[i] = particles.planets[i].color;
+    }
+    snapshot.grid.build(snapshot.x, snapshot.y, snapshot.prevX, snapshot.prevY, snapshot.mass);
+    snapshot.steps = this->simulation.steps;
+    snapshot.alpha = this->simulation.getAlpha();
+    snapshot.stepsPerSecond = this->simulation.stepsPerSecond;
+    snapshot.measuredStepsPerSecond = this->measuredStepsPerSecond;
+    snapshot.published = std::chrono::steady_clock::now();
+    this->snapshots.publish();
+}
+
+void SimulationThread::run(){
+    setProfilerThreadName("simulation");
+    typedef std::chrono::steady_clock Clock;
+    Clock::time_point last = Clock::now();
+    Clock::time_point rateStart = last;
+    unsigned long rateSteps = 0;
+
+    while(this->running){
+        runCommands();
+
+        Clock::time_point now = Clock::now();
+        unsigned int steps = this->simulation.advance(std::chrono::duration<double>(now - last).count());
+        last = now;
+
+        rateSteps += steps;
+        double rateSeconds = std::chrono::duration<double>(now - rateStart).count();
+        if(rateSeconds >= SIM_RATE_WINDOW){
+            this->measuredStepsPerSecond = rateSteps / rateSeconds;
+            rateStart = now;
+            rateSteps = 0;
+        }
+
+        if(steps > 0){
+            publish();
+        }else{
+            //Ahead of the fixed rate, sleep until the next step is due
+            double wait = (1.0 - this->simulation.getAlpha()) / this->simulation.stepsPerSecond;
+            std::this_thread::sleep_for(std::chrono::duration<double>(std::max(wait, 0.0)));
+        }
+    }
+}
@@ -0,0 +1,137 @@
+#include "spatialhash.hpp"
+#include <algorithm>
+#include <cmath>
+#include "profiler.hpp"
+
+#define SPATIAL_HASH_MAX_CELL 1e15 //Cell coordinates are clamped so far away bodies stay in range
+
+SpatialHash::SpatialHash(){
+    this->cellSize = 1.0f;
+    this->mask = SPATIAL_HASH_MIN_BUCKETS - 1;
+}
+
+unsigned int SpatialHash::bucket(long long x, long long y) const{
+    unsigned long long hash = (unsigned long long)x * 73856093ull ^ (unsigned long long)y * 19349663ull;
+    return (unsigned int)(hash ^ (hash >> 32)) & this->mask;
+}
+
+long long SpatialHash::cell(float position) const{
+    double index = std::floor((double)position / this->cellSize);
+    return (long long)std::fmin(std::fmax(index, -SPATIAL_HASH_MAX_CELL), SPATIAL_HASH_MAX_CELL);
+}
+
+void SpatialHash::build(const ParticleSystem& particles, const std::vector<float>& radius){
+    size_t count = particles.size();
+
+    //Cells a few mean radii wide, anything wider than a cell is searched separately
+    double radiusSum = 0.0;
+    for(size_t i = 0; i < count; i++){
+        radiusSum += radius[i];
+    }
+    this->cellSize = count > 0 ? std::fmax(SPATIAL_HASH_CELL_RADII * radiusSum / count, 1e-6) : 1.0f;
+
+    unsigned int buckets = SPATIAL_HASH_MIN_BUCKETS;
+    while(buckets < count){
+        buckets *= 2;
+    }
+    this->mask = buckets - 1;
+
+    //Counting sort of the small bodies by bucket
+    this->cellX.resize(count);
+    this->cellY.resize(count);
+    this->bucketStart.assign(buckets + 1, 0);
+    this->large.clear();
+    for(size_t i = 0; i < count; i++){
+        this->cellX[i] = cell(particles.x[i]);
+        this->cellY[i] = cell(particles.y[i]);
+        if(2 * radius[i] > this->cellSize){
+            this->large.push_back(i);
+            continue;
+        }
+        this->bucketStart[bucket(this->cellX[i], this->cellY[i]) + 1]++;
+    }
+    for(unsigned int b = 0; b < buckets; b++){
+        this->bucketStart[b + 1] += this->bucketStart[b];
+    }
+    this->entries.resize(this->bucketStart[buckets]);
+    for(size_t i = 0; i < count; i++){
+        if(2 * radius[i] <= this->cellSize){
+            //bucketStart[b] doubles as the insert cursor and ends up at the start of bucket b + 1
+            this->entries[this->bucketStart[bucket(this->cellX[i], this->cellY[i])]++] = i;
+        }
+    }
+    for(unsigned int b = buckets; b > 0; b--){
+        this->bucketStart[b] = this->bucketStart[b - 1];
+    }
+    this->bucketStart[0] = 0;
+}
+
+void SpatialHash::findOverlaps(const ParticleSystem& particles, const std::vector<float>& radius, std::vector<std::pair<int, int>>& pairs){
+    PROFILE_ZONE("SpatialHash::findOverlaps");
+    build(particles, radius);
+    pairs.clear();
+    size_t count = particles.size();
+
+    auto overlaps = [&](int i, int j){
+        float dx = particles.x[j] - particles.x[i];
+        float dy = particles.y[j] - particles.y[i];
+        float reach = radius[i] + radius[j];
+        return dx * dx + dy * dy < reach * reach;
+    };
+
+    //Small bodies: two discs no wider than a cell can only touch from neighbouring cells
+    for(size_t i = 0; i < count; i++){
+        if(2 * radius[i] > this->cellSize){
+            continue;
+        }
+        for(long long y = this->cellY[i] - 1; y <= this->cellY[i] + 1; y++){
+            for(long long x = this->cellX[i] - 1; x <= this->cellX[i] + 1; x++){
+                unsigned int b = bucket(x, y);
+                for(unsigned int e = this->bucketStart[b]; e < this->bucketStart[b + 1]; e++){
+                    //Other cells can share the bucket, and each pair is only reported from its lower index
+                    int j = this->entries[e];
+                    if(j > (int)i && this->cellX[j] == x && this->cellY[j] == y && overlaps(i, j)){
+                        pairs.push_back({(int)i, j});
+                    }
+                }
+            }
+        }
+    }
+
+    //Large bodies: every small body in the cells they can reach, then each other
+    float smallRadius = this->cellSize / 2;
+    for(size_t l = 0; l < this->large.size(); l++){
+        int i = this->large[l];
+        float reach = radius[i] + smallRadius;
+        long long minX = cell(particles.x[i] - reach), maxX = cell(particles.x[i] + reach);
+        long long minY = cell(particles.y[i] - reach), maxY = cell(particles.y[i] + reach);
+        if((double)(maxX - minX + 1) * (maxY - minY + 1) > this->entries.size()){
+            //Reaches over more cells than there are bodies, cheaper to test them all
+            for(int j: this->entries){
+                if(overlaps(i, j)){
+                    pairs.push_back({std::min(i, j), std::max(i, j)});
+                }
+            }
+        }else{
+            for(long long y = minY; y <= maxY; y++){
+                for(long long x = minX; x <= maxX; x++){
+                    unsigned int b = bucket(x, y);
+                    for(unsigned int e = this->bucketStart[b]; e < this->bucketStart[b + 1]; e++){
+                        int j = this->entries[e];
+                        if(this->cellX[j] == x && this->cellY[j] == y && overlaps(i, j)){
+                            pairs.push_back({std::min(i, j), std::max(i, j)});
+                        }
+                    }
+                }
+            }
+        }
+        for(size_t k = l + 1; k < this->large.size(); k++){
+            if(overlaps(i, this->large[k])){
+                pairs.push_back({std::min(i, this->large[k]), std::max(i, this->large[k])});
+            }
+        }
+    }
+
+    //The large body pairs came last, sort so merging sees every pair in index order
+    std::sort(pairs.begin(), pairs.end());
+}
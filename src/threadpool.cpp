@@ -0,0 +1,98 @@
+#include "threadpool.hpp"
+#include <algorithm>
+#include <string>
+#include "profiler.hpp"
+
+ThreadPool::ThreadPool(unsigned int threadCount){
+    if(threadCount == 0){
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    this->task = nullptr;
+    this->blockCount = 0;
+    this->nextBlock = 0;
+    this->busyWorkers = 0;
+    this->generation = 0;
+    this->stopping = false;
+    for(unsigned int i = 1; i < threadCount; i++){
+        this->workers.push_back(std::thread(&ThreadPool::workerLoop, this, i));
+    }
+}
+
+ThreadPool::~ThreadPool(){
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->wake.notify_all();
+    for(std::thread& worker: this->workers){
+        worker.join();
+    }
+}
+
+unsigned int ThreadPool::getThreadCount() const{
+    return this->workers.size() + 1;
+}
+
+void ThreadPool::run(unsigned int blockCount, const BlockTask& task){
+    if(this->workers.empty() || blockCount <= 1){
+        for(unsigned int block = 0; block < blockCount; block++){
+            task(block, 0);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->task = &task;
+        this->blockCount = blockCount;
+        this->nextBlock = 0;
+        this->busyWorkers = this->workers.size();
+        this->generation++;
+    }
+    this->wake.notify_all();
+
+    drainBlocks(0);
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->done.wait(lock, [this]{ return this->busyWorkers == 0; });
+    this->task = nullptr;
+}
+
+void runBlocks(ThreadPool* pool, unsigned int blockCount, const BlockTask& task){
+    if(pool != nullptr){
+        pool->run(blockCount, task);
+        return;
+    }
+    for(unsigned int block = 0; block < blockCount; block++){
+        task(block, 0);
+    }
+}
+
+void ThreadPool::drainBlocks(unsigned int thread){
+    unsigned int block;
+    while((block = this->nextBlock.fetch_add(1)) < this->blockCount){
+        (*this->task)(block, thread);
+    }
+}
+
+void ThreadPool::workerLoop(unsigned int thread){
+    setProfilerThreadName("worker " + std::to_string(thread));
+    unsigned long seenGeneration = 0;
+    while(true){
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->wake.wait(lock, [&]{ return this->stopping || this->generation != seenGeneration; });
+            if(this->stopping){
+                return;
+            }
+            seenGeneration = this->generation;
+        }
+
+        drainBlocks(thread);
+
+        std::lock_guard<std::mutex> lock(this->mutex);
+        if(--this->busyWorkers == 0){
+            this->done.notify_one();
+        }
+    }
+}
@@ -0,0 +1,238 @@
+#include "trajectory.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include "profiler.hpp"
+
+namespace {
+
+//Little endian on any host
+void putU32(std::vector<unsigned char>& out, uint32_t value){
+    for(int i = 0; i < 4; i++){
+        out.push_back((value >> (8 * i)) & 0xFF);
+    }
+}
+
+void putU64(std::vector<unsigned char>& out, uint64_t value){
+    for(int i = 0; i < 8; i++){
+        out.push_back((value >> (8 * i)) & 0xFF);
+    }
+}
+
+void putF32(std::vector<unsigned char>& out, float value){
+    uint32_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    putU32(out, bits);
+}
+
+void putF64(std::vector<unsigned char>& out, double value){
+    uint64_t bits;
+    std::memcpy(&bits, &value, sizeof(bits));
+    putU64(out, bits);
+}
+
+//Zigzag maps small negative and positive differences alike to small unsigned values, 7 bits per byte
+void putVarint(std::vector<unsigned char>& out, long long value){
+    uint64_t zigzag = ((uint64_t)value << 1) ^ (uint64_t)(value >> 63);
+    while(zigzag >= 0x80){
+        out.push_back((zigzag & 0x7F) | 0x80);
+        zigzag >>= 7;
+    }
+    out.push_back(zigzag);
+}
+
+}
+
+TrajectoryRecorder::TrajectoryRecorder(){
+    this->head = 0;
+    this->tail = 0;
+    this->queued = 0;
+    this->closing = false;
+    this->failed = false;
+    this->interval = 1;
+    this->encoding = TrajectoryEncoding::Raw;
+    this->quantum = TRAJECTORY_QUANTUM;
+    this->frameCount = 0;
+    this->stalls = 0;
+    this->bytes = 0;
+}
+
+TrajectoryRecorder::~TrajectoryRecorder(){
+    close();
+}
+
+bool TrajectoryRecorder::open(const std::string& path, const Simulation& simulation, unsigned int interval, const std::vector<unsigned int>& ids,
+                              TrajectoryEncoding encoding, double quantum){
+    close();
+    this->ids = ids;
+    if(this->ids.empty()){
+        this->ids.assign(simulation.particles.ids.begin(), simulation.particles.ids.end());
+    }
+    for(unsigned int id: this->ids){
+        if(simulation.particles.indexOf(id) < 0){
+            std::cerr << "Trajectory " << path << ": no body with id " << id << std::endl;
+            return false;
+        }
+    }
+    this->file.open(path, std::ios::binary | std::ios::trunc);
+    if(!this->file.is_open()){
+        std::cerr << "Trajectory " << path << ": unable to open" << std::endl;
+        return false;
+    }
+    this->interval = interval > 0 ? interval : 1;
+    this->encoding = encoding;
+    this->quantum = quantum;
+    this->frameCount = 0;
+    this->stalls = 0;
+    this->failed = false;
+    this->closing = false;
+    this->head = this->tail = this->queued = 0;
+    this->lastX.assign(this->ids.size(), 0);
+    this->lastY.assign(this->ids.size(), 0);
+
+    //Every buffer sized for the whole selection now, recording never allocates
+    for(Frame& frame: this->frames){
+        frame.present.assign((this->ids.size() + 7) / 8, 0);
+        frame.x.reserve(this->ids.size());
+        frame.y.reserve(this->ids.size());
+    }
+    this->encoded.clear();
+    this->encoded.reserve(32 + this->ids.size() * 2 * sizeof(float));
+
+    std::vector<unsigned char> header(TRAJECTORY_MAGIC, TRAJECTORY_MAGIC + 8);
+    putU32(header, TRAJECTORY_VERSION);
+    putU32(header, (uint32_t)encoding);
+    putF64(header, quantum);
+    putU32(header, this->interval);
+    putU32(header, this->ids.size());
+    for(unsigned int id: this->ids){
+        putU32(header, id);
+    }
+    this->file.write(reinterpret_cast<const char*>(header.data()), header.size());
+    this->bytes = header.size();
+    this->failed = !this->file.good();
+
+    this->writer = std::thread(&TrajectoryRecorder::run, this);
+    return true;
+}
+
+void TrajectoryRecorder::record(const Simulation& simulation){
+    if(!this->writer.joinable() || simulation.steps % this->interval != 0){
+        return;
+    }
+    PROFILE_ZONE("TrajectoryRecorder::record");
+    {
+        std::unique_lock<std::mutex> lock(this->mutex);
+        if(this->queued == TRAJECTORY_BUFFERS){
+            this->stalls++;
+            this->changed.wait(lock, [this]{ return this->queued < TRAJECTORY_BUFFERS; });
+        }
+    }
+
+    //The head frame is ours until it is queued, the writer only reads frames between tail and head
+    Frame& frame = this->frames[this->head];
+    const ParticleSystem& particles = simulation.particles;
+    frame.step = simulation.steps;
+    frame.time = simulation.time;
+    std::fill(frame.present.begin(), frame.present.end(), 0);
+    frame.x.clear();
+    frame.y.clear();
+    for(size_t k = 0; k < this->ids.size(); k++){
+        int i = particles.indexOf(this->ids[k]);
+        if(i < 0){
+            continue;
+        }
+        frame.present[k / 8] |= 1 << (k % 8);
+        frame.x.push_back(particles.x[i]);
+        frame.y.push_back(particles.y[i]);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->head = (this->head + 1) % TRAJECTORY_BUFFERS;
+        this->queued++;
+    }
+    this->changed.notify_all();
+    this->frameCount++;
+}
+
+void TrajectoryRecorder::run(){
+    setProfilerThreadName("trajectory");
+    std::unique_lock<std::mutex> lock(this->mutex);
+    while(true){
+        this->changed.wait(lock, [this]{ return this->queued > 0 || this->closing; });
+        if(this->queued == 0){
+            break;
+        }
+        //Encode and write without the lock, the simulation keeps filling the other buffers
+        const Frame& frame = this->frames[this->tail];
+        lock.unlock();
+        encode(frame);
+        this->file.write(reinterpret_cast<const char*>(this->encoded.data()), this->encoded.size());
+        this->bytes += this->encoded.size();
+        lock.lock();
+        this->failed = this->failed || !this->file.good();
+        this->tail = (this->tail + 1) % TRAJECTORY_BUFFERS;
+        this->queued--;
+        this->changed.notify_all();
+    }
+}
+
+void TrajectoryRecorder::encode(const Frame& frame){
+    PROFILE_ZONE("TrajectoryRecorder::encode");
+    std::vector<unsigned char>& out = this->encoded;
+    out.clear();
+    putU64(out, frame.step);
+    putF64(out, frame.time);
+    putU32(out, frame.x.size());
+    out.insert(out.end(), frame.present.begin(), frame.present.end());
+    if(this->encoding == TrajectoryEncoding::Raw){
+        for(size_t p = 0; p < frame.x.size(); p++){
+            putF32(out, frame.x[p]);
+            putF32(out, frame.y[p]);
+        }
+        return;
+    }
+    size_t p = 0;
+    for(size_t k = 0; k < this->ids.size(); k++){
+        if((frame.present[k / 8] & (1 << (k % 8))) == 0){
+            continue;
+        }
+        long long x = std::llround(frame.x[p] / this->quantum);
+        long long y = std::llround(frame.y[p] / this->quantum);
+        putVarint(out, x - this->lastX[k]);
+        putVarint(out, y - this->lastY[k]);
+        this->lastX[k] = x;
+        this->lastY[k] = y;
+        p++;
+    }
+}
+
+bool TrajectoryRecorder::close(){
+    if(!this->writer.joinable()){
+        return !this->failed;
+    }
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->closing = true;
+    }
+    this->changed.notify_all();
+    this->writer.join();
+    this->file.close();
+    this->failed = this->failed || this->file.fail();
+    return !this->failed;
+}
+
+unsigned long TrajectoryRecorder::getFrames() const{
+    return this->frameCount;
+}
+
+unsigned long TrajectoryRecorder::getStalls() const{
+    return this->stalls;
+}
+
+unsigned long long TrajectoryRecorder::getBytes() const{
+    return this->bytes;
+}